@@ -0,0 +1,275 @@
+/**
+ *          15-418 Final Project
+ *          Title:  Congestion Aware Map Routing
+ *          Credit: Parth Iyer   (pniyer@andrew.cmu.edu)
+ *                  Kwaku Baryeh (kbaryeh@andrew.cmu.edu)
+ */
+
+#include "alternatives.h"
+#include "astar.h"
+#include "simulation.h"
+#include "log.h"
+#include <map>
+#include <cmath>
+#include <climits>
+#include <algorithm>
+
+// Each earlier route through an edge adds this percentage of its cost.
+static const int ALT_PENALTY_PCT = 40;
+
+// The penalty searches of a group run on one thread, so the counts are
+// thread local.
+static thread_local const int *penalty_hits = NULL;
+
+struct PenaltyCost {
+    static int cost(const Graph &graph, const Edge &edge) {
+        int base = StaticCost::cost(graph, edge);
+        return base + base * penalty_hits[edge.id] * ALT_PENALTY_PCT / 100;
+    }
+};
+
+static bool shortest_route(const Graph &graph, int from, int to, std::vector<int> &route) {
+    return a_star_search<AStarQueue, StaticCost, AStarHeuristic>(graph, from, to, route);
+}
+
+// The static cost of a route.
+static int route_static_cost(const Graph &graph, const std::vector<int> &route) {
+    int cost = 0;
+    for (size_t k = 1; k < route.size(); k++)
+        cost += StaticCost::cost(graph, graph.edges[route[k - 1]][find_edge(graph, route[k - 1], route[k])]);
+    return cost;
+}
+
+int group_trips(AlternativeRoutes &alt, const Graph &graph, const VehicleTable &vt, int k, double stretch) {
+    alt.k = k;
+    alt.stretch = stretch;
+    alt.groups.clear();
+    int n = vt.position.size();
+    alt.group.assign(n, -1);
+    alt.held.assign(graph.num_edges, std::vector<std::pair<int, int>>());
+    if (graph.vertices.empty())
+        return 0;
+
+    // A square grid over the bounding box of the vertices.
+    int minX = INT_MAX, minY = INT_MAX, maxX = INT_MIN, maxY = INT_MIN;
+    for (const Vertex &v : graph.vertices) {
+        minX = std::min(minX, v.x);
+        minY = std::min(minY, v.y);
+        maxX = std::max(maxX, v.x);
+        maxY = std::max(maxY, v.y);
+    }
+    int side = std::max(1, (int) std::lround(std::sqrt((double) graph.vertices.size() / ALT_CELL_VERTICES)));
+    auto cell = [&](int v) {
+        const Vertex &p = graph.vertices[v];
+        int cx = (long) (p.x - minX) * side / (maxX - minX + 1);
+        int cy = (long) (p.y - minY) * side / (maxY - minY + 1);
+        return cy * side + cx;
+    };
+
+    std::map<std::pair<int, int>, std::vector<int>> trips;
+    for (int i = 0; i < n; i++) {
+        int a = cell(vt.origin[i]), b = cell(vt.dest[i]);
+        if (a != b)
+            trips[std::make_pair(a, b)].push_back(i);
+    }
+    for (const auto &entry : trips) {
+        const std::vector<int> &members = entry.second;
+        if ((int) members.size() < ALT_MIN_TRIPS)
+            continue;
+        AltGroup g;
+        g.origin = vt.origin[members[0]];
+        g.dest = vt.dest[members[0]];
+        for (int i : members)
+            alt.group[i] = alt.groups.size();
+        alt.groups.push_back(g);
+    }
+    return alt.groups.size();
+}
+
+void generate_alternatives(AlternativeRoutes &alt, const Graph &graph, int g) {
+    AltGroup &group = alt.groups[g];
+    static thread_local std::vector<int> hits;
+    static thread_local std::vector<char> onRoute;
+    hits.assign(graph.num_edges, 0);
+    onRoute.assign(graph.vertices.size(), 0);
+    penalty_hits = hits.data();
+
+    std::vector<int> route;
+    if (!shortest_route(graph, group.origin, group.dest, route))
+        return;
+    Alternative best;
+    best.via = -1;
+    best.cost = route_static_cost(graph, route);
+    group.alts.push_back(best);
+    int limit = (int) ((1 + alt.stretch) * best.cost);
+
+    // A few searches more than alternatives, as some repeat earlier routes.
+    for (int attempt = 0; attempt < 3 * alt.k && (int) group.alts.size() < alt.k; attempt++) {
+        for (size_t k = 0; k < route.size(); k++) {
+            onRoute[route[k]] = 1;
+            if (k > 0)
+                hits[graph.edges[route[k - 1]][find_edge(graph, route[k - 1], route[k])].id]++;
+        }
+        if (!a_star_search<AStarQueue, PenaltyCost, AStarHeuristic>(graph, group.origin, group.dest, route))
+            break;
+        Alternative a;
+        a.cost = route_static_cost(graph, route);
+        if (a.cost > limit)
+            break;
+        // The new vertex nearest the middle of the route identifies it.
+        a.via = -1;
+        int mid = route.size() / 2;
+        for (int d = 0; d <= mid && a.via < 0; d++) {
+            if (!onRoute[route[mid - d]])
+                a.via = route[mid - d];
+            else if (mid + d < (int) route.size() && !onRoute[route[mid + d]])
+                a.via = route[mid + d];
+        }
+        if (a.via >= 0)
+            group.alts.push_back(a);
+    }
+    penalty_hits = NULL;
+}
+
+int queue_departures(AlternativeRoutes &alt, const VehicleTable &vt, size_t from) {
+    alt.pending.assign(vt.active.begin() + from, vt.active.end());
+    std::sort(alt.pending.begin(), alt.pending.end());
+    alt.direct_routes.resize(alt.pending.size());
+    return alt.pending.size();
+}
+
+// A lower bound on the cost of any route between u and v, as every edge
+// costs its Manhattan length.
+static int manhattan(const Graph &graph, int u, int v) {
+    const Vertex &a = graph.vertices[u];
+    const Vertex &b = graph.vertices[v];
+    return abs(a.x - b.x) + abs(a.y - b.y);
+}
+
+// Cuts out the loops of a route made of two legs which cross.
+static void cut_loops(const Graph &graph, std::vector<int> &route) {
+    static thread_local std::vector<int> seenAt;
+    seenAt.resize(graph.vertices.size(), -1);
+    size_t len = 0;
+    for (int v : route) {
+        if (seenAt[v] >= 0) {
+            for (size_t j = seenAt[v] + 1; j < len; j++)
+                seenAt[route[j]] = -1;
+            len = seenAt[v] + 1;
+            continue;
+        }
+        seenAt[v] = len;
+        route[len++] = v;
+    }
+    route.resize(len);
+    for (int v : route)
+        seenAt[v] = -1;
+}
+
+void plan_direct(AlternativeRoutes &alt, const Graph &graph, const VehicleTable &vt, int k) {
+    int i = alt.pending[k];
+    if (!find_route(graph, vt.position[i], vt.dest[i], alt.direct_routes[k]))
+        alt.direct_routes[k].clear();
+}
+
+// The earliest time from t on at which fewer than `capacity` vehicles are
+// predicted to hold the edge.
+static int free_at(const std::vector<std::pair<int, int>> &held, int capacity, int t) {
+    while (true) {
+        int holders = 0, next = INT_MAX;
+        for (const std::pair<int, int> &h : held) {
+            if (h.first <= t && t < h.second) {
+                holders++;
+                next = std::min(next, h.second);
+            }
+        }
+        if (holders < capacity || next == INT_MAX)
+            return t;
+        t = next;
+    }
+}
+
+// Replays a route departing at `depart`: the vehicle enters each edge once
+// fewer than its capacity hold it, and holds it until it enters the next.
+// Returns the arrival time and, with `commit`, adds the holds to alt.held.
+static int predict_route(AlternativeRoutes &alt, const Graph &graph, const std::vector<int> &route,
+                         int depart, bool commit) {
+    int t = depart, prev = -1, entered = 0;
+    for (size_t k = 1; k < route.size(); k++) {
+        const Edge &edge = graph.edges[route[k - 1]][find_edge(graph, route[k - 1], route[k])];
+        t = free_at(alt.held[edge.id], edge.capacity, t);
+        if (commit && prev >= 0)
+            alt.held[prev].push_back(std::make_pair(entered, t));
+        prev = edge.id;
+        entered = t;
+        t += StaticCost::cost(graph, edge);
+    }
+    if (commit && prev >= 0)
+        alt.held[prev].push_back(std::make_pair(entered, t));
+    return t;
+}
+
+// Routes vehicle i from `from` over `via` to `to`, if that costs at most
+// `limit`.
+static bool route_via(const Graph &graph, int from, int via, int to, int limit, std::vector<int> &route) {
+    std::vector<int> rest;
+    if (!find_route(graph, from, via, route) ||
+        route_static_cost(graph, route) + manhattan(graph, via, to) > limit || !find_route(graph, via, to, rest))
+        return false;
+    route.insert(route.end(), rest.begin() + 1, rest.end());
+    cut_loops(graph, route);
+    return route_static_cost(graph, route) <= limit;
+}
+
+void assign_alternatives(AlternativeRoutes &alt, const Graph &graph, VehicleTable &vt) {
+    std::vector<int> route;
+    for (size_t k = 0; k < alt.pending.size(); k++) {
+        std::vector<int> &best = alt.direct_routes[k];
+        if (best.empty())
+            continue;
+        int i = alt.pending[k];
+        int from = vt.position[i], to = vt.dest[i], depart = vt.depart[i];
+        int cost = route_static_cost(graph, best);
+        int direct = predict_route(alt, graph, best, depart, false);
+        int arrival = direct;
+
+        // Only a vehicle predicted to wait on its direct route looks further,
+        // and only at the vias whose Manhattan bound could arrive earlier.
+        if (arrival > depart + cost && alt.group[i] >= 0) {
+            int limit = (int) ((1 + alt.stretch) * cost);
+            for (const Alternative &a : alt.groups[alt.group[i]].alts) {
+                int bound = manhattan(graph, from, a.via) + manhattan(graph, a.via, to);
+                if (a.via < 0 || a.via == from || a.via == to || bound > limit || depart + bound >= arrival)
+                    continue;
+                alt.searched++;
+                if (!route_via(graph, from, a.via, to, limit, route))
+                    continue;
+                int t = predict_route(alt, graph, route, depart, false);
+                if (t < arrival) {
+                    arrival = t;
+                    best.swap(route);
+                }
+            }
+            if (arrival < direct) {
+                alt.assigned++;
+                alt.saved += direct - arrival;
+            } else {
+                alt.direct++;
+            }
+        }
+        predict_route(alt, graph, best, depart, true);
+        set_route(graph, vt, i, best);
+    }
+}
+
+void report_alternatives(const AlternativeRoutes &alt) {
+    if (alt.k < 2)
+        return;
+    unsigned long alternatives = 0;
+    for (const AltGroup &g : alt.groups)
+        alternatives += g.alts.size();
+    LOG_INFO("Alternative routes: " << (unsigned long) alt.groups.size() << " popular trips, "
+             << alternatives << " routes in " << alt.build_ns / 1e6 << " ms, " << alt.assigned + alt.direct
+             << " of their vehicles predicted to wait, " << alt.searched << " via routes searched for them, "
+             << alt.assigned << " sent over a via vertex, " << alt.saved << " predicted cost saved");
+}
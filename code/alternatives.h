@@ -0,0 +1,146 @@
+/**
+ *          15-418 Final Project
+ *          Title:  Congestion Aware Map Routing
+ *          Credit: Parth Iyer   (pniyer@andrew.cmu.edu)
+ *                  Kwaku Baryeh (kbaryeh@andrew.cmu.edu)
+ */
+
+#ifndef ALTERNATIVES_H
+#define ALTERNATIVES_H
+
+#include "graph.h"
+#include "vehicles.h"
+#include <vector>
+#include <cstddef>
+
+/**
+ * Alternative routes for popular trips, so the vehicles making them do not
+ * all pile onto the one shortest path. Trips are grouped by the cells of a
+ * coarse grid their origin and destination fall in, about ALT_CELL_VERTICES
+ * vertices each; a pair of distinct cells with at least ALT_MIN_TRIPS trips
+ * is popular. For each, up to k alternatives between the endpoints of its
+ * first trip are found with the penalty method: every search after the first
+ * makes the edges of the routes found so far dearer, and a route is kept if
+ * it costs at most 1 + stretch times the shortest one and passes a vertex
+ * none of the kept routes does. An alternative is remembered by that via
+ * vertex; a vehicle assigned to it drives its own shortest route to the via
+ * vertex and on from there, unless that costs more than 1 + stretch times
+ * its direct route.
+ *
+ * A departing vehicle takes the route, its direct one or one over a via
+ * vertex, with the earliest predicted arrival. The prediction replays the
+ * route on the clock the cost is measured in, where a vehicle holds an edge
+ * from entering it until it enters the next, and enters an edge only while
+ * fewer than its capacity hold it. The edges are held as predicted for the
+ * vehicles assigned before, so a vehicle only detours when the edges of its
+ * direct route are predicted to be full when it gets there, and the detour
+ * is predicted to make up for its length.
+ */
+
+const int ALT_CELL_VERTICES = 256;
+const int ALT_MIN_TRIPS = 2;
+
+/**
+ * @name                Alternative
+ * @param via           The vertex the alternative passes (-1 for the shortest)
+ * @param cost          Its static cost between the group's endpoints
+ */
+struct Alternative {
+    int via;
+    int cost;
+};
+
+/**
+ * @name                AltGroup
+ * @param origin, dest  The endpoints of the group's first trip
+ * @param alts          Its alternatives, shortest first
+ */
+struct AltGroup {
+    int origin;
+    int dest;
+    std::vector<Alternative> alts;
+};
+
+/**
+ * @name                AlternativeRoutes
+ * @param k             The most alternatives per group
+ * @param stretch       How much longer than the shortest route one may be
+ * @param groups        The popular cell pairs
+ * @param group         The group of each vehicle, or -1
+ * @param pending       The vehicles departing now, by id
+ * @param direct_routes The direct route of each of `pending` (empty if none)
+ * @param held          The predicted (enter, leave) times of each edge id
+ * @param assigned      Vehicles routed over a via vertex so far
+ * @param direct        Vehicles predicted to wait which kept the direct route
+ * @param searched      Via routes searched for the vehicles predicted to wait
+ * @param saved         Predicted cost saved over the direct routes
+ * @param build_ns      Time spent generating the alternatives
+ */
+struct AlternativeRoutes {
+    int k;
+    double stretch;
+    std::vector<AltGroup> groups;
+    std::vector<int> group;
+    std::vector<int> pending;
+    std::vector<std::vector<int>> direct_routes;
+    std::vector<std::vector<std::pair<int, int>>> held;
+    unsigned long assigned;
+    unsigned long direct;
+    unsigned long searched;
+    unsigned long saved;
+    unsigned long build_ns;
+
+    AlternativeRoutes() : k(0), stretch(0), assigned(0), direct(0), searched(0), saved(0), build_ns(0) {}
+};
+
+/**
+ * @name                group_trips
+ * @details             Groups the vehicles of `vt` by cell pair and sets up an
+ *                      empty group for each popular pair.
+ *
+ * @return              The number of groups
+ */
+int group_trips(AlternativeRoutes &alt, const Graph &graph, const VehicleTable &vt, int k, double stretch);
+
+/**
+ * @name                generate_alternatives
+ * @details             Finds the alternatives of group g. Groups may be
+ *                      generated on any threads at once.
+ */
+void generate_alternatives(AlternativeRoutes &alt, const Graph &graph, int g);
+
+/**
+ * @name                queue_departures
+ * @details             Queues the vehicles in vt.active[from..] to be routed.
+ *
+ * @return              The number queued
+ */
+int queue_departures(AlternativeRoutes &alt, const VehicleTable &vt, size_t from);
+
+/**
+ * @name                plan_direct
+ * @details             Finds the direct route of queued vehicle k with the
+ *                      router in use (see find_route). Any thread may plan
+ *                      any k once queue_departures returned.
+ */
+void plan_direct(AlternativeRoutes &alt, const Graph &graph, const VehicleTable &vt, int k);
+
+/**
+ * @name                assign_alternatives
+ * @details             Routes every queued vehicle and adds its predicted
+ *                      holds. A vehicle predicted to wait on its direct route
+ *                      takes the route over one of its group's via vertices
+ *                      instead if that costs at most 1 + stretch times the
+ *                      direct one and is predicted to arrive earlier. Serial
+ *                      and in id order, so the choice does not depend on the
+ *                      threads.
+ */
+void assign_alternatives(AlternativeRoutes &alt, const Graph &graph, VehicleTable &vt);
+
+/**
+ * @name                report_alternatives
+ * @details             Logs the groups, alternatives and vehicles routed.
+ */
+void report_alternatives(const AlternativeRoutes &alt);
+
+#endif // ALTERNATIVES_H
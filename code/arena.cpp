@@ -0,0 +1,216 @@
+/**
+ *          15-418 Final Project
+ *          Title:  Congestion Aware Map Routing
+ *          Credit: Parth Iyer   (pniyer@andrew.cmu.edu)
+ *                  Kwaku Baryeh (kbaryeh@andrew.cmu.edu)
+ */
+
+#include "arena.h"
+#include <mutex>
+#include <cstdlib>
+#include <cstring>
+#include <stdio.h>
+#include <stdint.h>
+#include <sys/mman.h>
+
+static const size_t HUGE_PAGE_BYTES = 2 << 20;
+// Chunks are at least this big, so a graph takes a handful of them.
+static const size_t ARENA_CHUNK_BYTES = 32 << 20;
+static const size_t ARENA_ALIGN = 16;
+
+/**
+ * @name                ArenaChunk
+ * @param base          Its first byte, 2 MB aligned
+ * @param size          Its bytes, a multiple of 2 MB
+ * @param offset        The first byte not handed out yet
+ * @param live          Bytes handed out and not freed yet
+ * @param explicitPages Whether it came from the hugetlb pool
+ * @param node          The NUMA node whose threads allocate from it, or -1
+ */
+struct ArenaChunk {
+    char *base;
+    size_t size;
+    size_t offset;
+    size_t live;
+    bool explicitPages;
+    int node;
+};
+
+static std::mutex arena_lock;
+static HugePageMode arena_mode = HUGE_PAGES_THP;
+// Chunks in the order they were mapped; the last one of each node is bumped.
+static ArenaChunk *chunks = NULL;
+static size_t num_chunks = 0, max_chunks = 0;
+static bool warned_explicit = false;
+static thread_local int arena_node = -1;
+
+bool parse_huge_page_mode(const std::string &name, HugePageMode &mode) {
+    if (name == "off")
+        mode = HUGE_PAGES_OFF;
+    else if (name == "thp")
+        mode = HUGE_PAGES_THP;
+    else if (name == "explicit")
+        mode = HUGE_PAGES_EXPLICIT;
+    else
+        return false;
+    return true;
+}
+
+void use_graph_arena(HugePageMode mode) {
+    std::lock_guard<std::mutex> guard(arena_lock);
+    arena_mode = mode;
+}
+
+void use_arena_node(int node) {
+    arena_node = node;
+}
+
+// The chunk `node` allocates from, or NULL before its first one.
+static ArenaChunk *current_chunk(int node) {
+    for (size_t k = num_chunks; k-- > 0;)
+        if (chunks[k].node == node)
+            return &chunks[k];
+    return NULL;
+}
+
+// Maps a 2 MB aligned chunk of `size` bytes, from the hugetlb pool if asked
+// and it has the pages, otherwise advised as transparent huge pages.
+static char *map_chunk(size_t size, bool &explicitPages) {
+    explicitPages = false;
+    if (arena_mode == HUGE_PAGES_EXPLICIT) {
+        void *mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (mem != MAP_FAILED) {
+            explicitPages = true;
+            return static_cast<char *>(mem);
+        }
+        if (!warned_explicit) {
+            fprintf(stderr, "No explicit huge pages available (see /proc/sys/vm/nr_hugepages), "
+                    "using transparent ones\n");
+            warned_explicit = true;
+        }
+    }
+
+    // Over-map by a huge page and trim, so the chunk starts on a boundary.
+    size_t span = size + HUGE_PAGE_BYTES;
+    void *mem = mmap(NULL, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED)
+        return NULL;
+    char *raw = static_cast<char *>(mem);
+    char *base = reinterpret_cast<char *>(((uintptr_t) raw + HUGE_PAGE_BYTES - 1) & ~(uintptr_t) (HUGE_PAGE_BYTES - 1));
+    if (base > raw)
+        munmap(raw, base - raw);
+    if (raw + span > base + size)
+        munmap(base + size, raw + span - (base + size));
+#ifdef MADV_HUGEPAGE
+    // Without THP in the kernel the chunk simply stays on small pages.
+    madvise(base, size, MADV_HUGEPAGE);
+#endif
+    return base;
+}
+
+static ArenaChunk *new_chunk(size_t bytes, int node) {
+    if (num_chunks == max_chunks) {
+        size_t grown = max_chunks ? 2 * max_chunks : 16;
+        ArenaChunk *more = static_cast<ArenaChunk *>(realloc(chunks, grown * sizeof(ArenaChunk)));
+        if (more == NULL)
+            return NULL;
+        chunks = more;
+        max_chunks = grown;
+    }
+    size_t size = bytes > ARENA_CHUNK_BYTES ? bytes : ARENA_CHUNK_BYTES;
+    size = (size + HUGE_PAGE_BYTES - 1) & ~(HUGE_PAGE_BYTES - 1);
+    ArenaChunk c;
+    c.base = map_chunk(size, c.explicitPages);
+    if (c.base == NULL)
+        return NULL;
+    c.size = size;
+    c.offset = c.live = 0;
+    c.node = node;
+    chunks[num_chunks] = c;
+    return &chunks[num_chunks++];
+}
+
+void *arena_allocate(size_t bytes) {
+    size_t rounded = (bytes + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+    if (rounded == 0)
+        rounded = ARENA_ALIGN;
+    {
+        std::lock_guard<std::mutex> guard(arena_lock);
+        if (arena_mode != HUGE_PAGES_OFF) {
+            ArenaChunk *c = current_chunk(arena_node);
+            if (c == NULL || c->size - c->offset < rounded)
+                c = new_chunk(rounded, arena_node);
+            if (c != NULL) {
+                void *ptr = c->base + c->offset;
+                c->offset += rounded;
+                c->live += rounded;
+                return ptr;
+            }
+        }
+    }
+    void *ptr = malloc(bytes ? bytes : 1);
+    if (ptr == NULL)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void arena_deallocate(void *ptr, size_t bytes) {
+    if (ptr == NULL)
+        return;
+    char *p = static_cast<char *>(ptr);
+    {
+        std::lock_guard<std::mutex> guard(arena_lock);
+        for (size_t k = num_chunks; k-- > 0;) {
+            ArenaChunk &c = chunks[k];
+            if (p < c.base || p >= c.base + c.size)
+                continue;
+            size_t rounded = (bytes + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+            c.live -= rounded ? rounded : ARENA_ALIGN;
+            if (c.live > 0)
+                return;
+            munmap(c.base, c.size);
+            memmove(&chunks[k], &chunks[k + 1], (num_chunks - k - 1) * sizeof(ArenaChunk));
+            num_chunks--;
+            return;
+        }
+    }
+    free(ptr);
+}
+
+GraphArenaStats graph_arena_stats() {
+    std::lock_guard<std::mutex> guard(arena_lock);
+    GraphArenaStats s;
+    s.mode = arena_mode;
+    s.nodes = 0;
+    s.chunks = num_chunks;
+    s.mapped = s.used = 0;
+    s.huge = 0;
+    for (size_t k = 0; k < num_chunks; k++) {
+        if (chunks[k].node >= 0 && current_chunk(chunks[k].node) == &chunks[k])
+            s.nodes++;
+        s.mapped += chunks[k].size;
+        s.used += chunks[k].live;
+    }
+
+    // Sum the huge pages of the mappings which overlap a chunk.
+    FILE *in = fopen("/proc/self/smaps", "r");
+    if (in == NULL) {
+        s.huge = -1;
+        return s;
+    }
+    char line[512];
+    bool ours = false;
+    while (fgets(line, sizeof(line), in)) {
+        unsigned long lo, hi, kb;
+        if (sscanf(line, "%lx-%lx ", &lo, &hi) == 2) {
+            ours = false;
+            for (size_t k = 0; k < num_chunks && !ours; k++)
+                ours = lo < (uintptr_t) chunks[k].base + chunks[k].size && (uintptr_t) chunks[k].base < hi;
+        } else if (ours && (sscanf(line, "AnonHugePages: %lu kB", &kb) == 1 ||
+                            sscanf(line, "Private_Hugetlb: %lu kB", &kb) == 1)) {
+            s.huge += (long) kb << 10;
+        }
+    }
+    fclose(in);
+    return s;
+}
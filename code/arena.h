@@ -0,0 +1,131 @@
+/**
+ *          15-418 Final Project
+ *          Title:  Congestion Aware Map Routing
+ *          Credit: Parth Iyer   (pniyer@andrew.cmu.edu)
+ *                  Kwaku Baryeh (kbaryeh@andrew.cmu.edu)
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <string>
+#include <cstddef>
+
+/**
+ * The graph arena. A* spends its time on cache and TLB misses: every pop
+ * reads the edge list of a vertex, and every edge the coordinates of a
+ * random neighbor. With 4 KB pages the vertex and edge arrays of a large
+ * graph span far more pages than the TLB holds, so the graph containers
+ * allocate from a few 2 MB aligned chunks backed by huge pages instead
+ * (see ArenaAllocator). Allocation bumps a pointer, so the edge lists built
+ * in vertex order also lie in vertex order. Freed blocks are only reclaimed
+ * once their whole chunk is free, which suits the graph: built once, freed
+ * all at once.
+ */
+
+enum HugePageMode {
+    HUGE_PAGES_OFF,         // Graph storage comes from malloc
+    HUGE_PAGES_THP,         // Chunks advised as transparent huge pages
+    HUGE_PAGES_EXPLICIT     // Chunks from the hugetlb pool, else as THP
+};
+
+/**
+ * @name                parse_huge_page_mode
+ * @details             Maps off, thp or explicit to the mode.
+ *
+ * @return              false if the name is unknown
+ */
+bool parse_huge_page_mode(const std::string &name, HugePageMode &mode);
+
+/**
+ * @name                use_graph_arena
+ * @details             Sets where graph storage allocated from now on comes
+ *                      from. Defaults to HUGE_PAGES_THP; storage allocated
+ *                      earlier stays where it is.
+ */
+void use_graph_arena(HugePageMode mode);
+
+/**
+ * @name                use_arena_node
+ * @details             Makes the calling thread's allocations come from the
+ *                      chunks of NUMA node `node`, or with -1 (the default)
+ *                      from those of no node in particular. The kernel
+ *                      puts a page on the node of the thread which first
+ *                      touches it, so a thread pinned to the node which fills
+ *                      a chunk places it there (see numa.h).
+ */
+void use_arena_node(int node);
+
+/**
+ * @name                arena_allocate
+ * @details             Allocates `bytes` from the calling thread's node's
+ *                      chunks, or with malloc when the arena is off or the
+ *                      kernel refuses the memory. Thread safe.
+ */
+void *arena_allocate(size_t bytes);
+
+/**
+ * @name                arena_deallocate
+ * @details             Frees a block of arena_allocate. An arena chunk is
+ *                      unmapped as soon as all its blocks are freed.
+ */
+void arena_deallocate(void *ptr, size_t bytes);
+
+/**
+ * @name                GraphArenaStats
+ * @param mode          The mode in use
+ * @param nodes         The NUMA nodes with chunks of their own
+ * @param chunks        Chunks mapped now
+ * @param mapped        Their bytes
+ * @param used          Bytes handed out from them and not yet freed
+ * @param huge          Bytes of them the kernel backs with huge pages, as
+ *                      /proc/self/smaps reports (-1 if it cannot be read)
+ */
+struct GraphArenaStats {
+    HugePageMode mode;
+    int nodes;
+    size_t chunks;
+    size_t mapped;
+    size_t used;
+    long huge;
+};
+
+/**
+ * @name                graph_arena_stats
+ * @details             Reads /proc/self/smaps, so call it once per report.
+ */
+GraphArenaStats graph_arena_stats();
+
+/**
+ * @name                ArenaAllocator
+ * @details             The standard allocator interface over the graph arena.
+ *                      Stateless: every instance allocates from the one arena
+ *                      and any may free what another allocated.
+ */
+template <class T>
+struct ArenaAllocator {
+    typedef T value_type;
+
+    ArenaAllocator() {}
+    template <class U>
+    ArenaAllocator(const ArenaAllocator<U> &) {}
+
+    T *allocate(size_t n) {
+        return static_cast<T *>(arena_allocate(n * sizeof(T)));
+    }
+    void deallocate(T *ptr, size_t n) {
+        arena_deallocate(ptr, n * sizeof(T));
+    }
+};
+
+template <class T, class U>
+bool operator==(const ArenaAllocator<T> &, const ArenaAllocator<U> &) {
+    return true;
+}
+
+template <class T, class U>
+bool operator!=(const ArenaAllocator<T> &, const ArenaAllocator<U> &) {
+    return false;
+}
+
+#endif // ARENA_H
@@ -0,0 +1,97 @@
+/**
+ *          15-418 Final Project
+ *          Title:  Congestion Aware Map Routing
+ *          Credit: Parth Iyer   (pniyer@andrew.cmu.edu)
+ *                  Kwaku Baryeh (kbaryeh@andrew.cmu.edu)
+ */
+
+#include "astar.h"
+#include "sequential.h"
+
+template bool a_star_search<AStarQueue, EdgeCost, AStarHeuristic>(
+    const Graph &, int, int, std::vector<int> &, int, int, double);
+template bool a_star_search<AStarQueue, StaticCost, AStarHeuristic>(
+    const Graph &, int, int, std::vector<int> &, int, int, double);
+template bool a_star_search<AStarQueue, LoadCost, AStarHeuristic>(
+    const Graph &, int, int, std::vector<int> &, int, int, double);
+
+EdgeCostMode edge_cost_mode = COST_STATIC;
+const int *edge_loads = NULL;
+
+static const Graph *pinned_graph = NULL;
+static int pinned_min_cost = 0;
+
+void pin_search_graph(const Graph *graph) {
+    pinned_graph = graph;
+    if (graph != NULL)
+        pinned_min_cost = (int) getMinimumEdgeCost(*graph);
+}
+
+int search_min_edge_cost(const Graph &graph) {
+    if (&graph == pinned_graph)
+        return pinned_min_cost;
+    return (int) getMinimumEdgeCost(graph);
+}
+
+// --------------------------------------------------------------------
+// Compute Manhattan distance between the two endpoints of an edge.
+int computeManhattanCost(const Graph &graph, const Edge &edge) {
+    int x1 = graph.vertices[edge.start].x;
+    int y1 = graph.vertices[edge.start].y;
+    int x2 = graph.vertices[edge.end].x;
+    int y2 = graph.vertices[edge.end].y;
+    return abs(x1 - x2) + abs(y1 - y2);
+}
+
+// --------------------------------------------------------------------
+// Compute dynamic cost for traversing an edge: the Manhattan cost, plus the
+// congestion on it when routing with --edge-cost load.
+float computeEdgeCost(const Graph &graph, const Edge &edge) {
+    return (float) edge_cost(graph, edge);
+}
+
+// --------------------------------------------------------------------
+// Return the minimum Manhattan cost among all edges in the graph.
+float getMinimumEdgeCost(const Graph &graph) {
+    float minCost = INF;
+    for (const auto &edgeList : graph.edges) {
+        for (const Edge &edge : edgeList) {
+            int cost = computeManhattanCost(graph, edge);
+            if (cost < minCost)
+                minCost = cost;
+        }
+    }
+    return minCost;
+}
+
+// --------------------------------------------------------------------
+// Manhattan-distance heuristic for A* search.
+float cost_heuristic(const Graph &graph, int current, int goal) {
+    int dx = abs(graph.vertices[current].x - graph.vertices[goal].x);
+    int dy = abs(graph.vertices[current].y - graph.vertices[goal].y);
+    int manhattan = dx + dy;
+    float minCost = search_min_edge_cost(graph);
+    return manhattan * minCost;
+}
+
+// --------------------------------------------------------------------
+// A* search to compute a route from start to goal under edge_cost, over the
+// open set and heuristic chosen at compile time.
+bool a_star(const Graph &graph, int start, int goal, std::vector<int> &path) {
+    return a_star_search<AStarQueue>(graph, start, goal, path);
+}
+
+// --------------------------------------------------------------------
+bool parse_edge_cost_mode(const std::string &name, EdgeCostMode &mode) {
+    if (name == "static")
+        mode = COST_STATIC;
+    else if (name == "load")
+        mode = COST_LOAD;
+    else
+        return false;
+    return true;
+}
+
+void use_edge_loads(const int *loads) {
+    edge_loads = loads;
+}
@@ -0,0 +1,440 @@
+/**
+ *          15-418 Final Project
+ *          Title:  Congestion Aware Map Routing
+ *          Credit: Parth Iyer   (pniyer@andrew.cmu.edu)
+ *                  Kwaku Baryeh (kbaryeh@andrew.cmu.edu)
+ */
+
+#ifndef ASTAR_H
+#define ASTAR_H
+
+#include "graph.h"
+#include "log.h"
+#include "instrument.h"
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <stdint.h>
+#include <stdlib.h>
+#include <climits>
+#include <string>
+
+/**
+ * The open set used by a_star is picked at compile time with
+ * `make ASTAR_QUEUE=bucket` (Dial's bucket queue) or the default
+ * `ASTAR_QUEUE=heap` (binary heap, the reference ordering).
+ */
+#define ASTAR_QUEUE_heap   0
+#define ASTAR_QUEUE_bucket 1
+
+#ifndef ASTAR_QUEUE
+#define ASTAR_QUEUE ASTAR_QUEUE_heap
+#endif
+
+/**
+ * Likewise the heuristic, with `make ASTAR_HEURISTIC=zero` (Dijkstra) or the
+ * default `ASTAR_HEURISTIC=manhattan`.
+ */
+#define ASTAR_HEURISTIC_manhattan 0
+#define ASTAR_HEURISTIC_zero      1
+
+#ifndef ASTAR_HEURISTIC
+#define ASTAR_HEURISTIC ASTAR_HEURISTIC_manhattan
+#endif
+
+/**
+ * `make ASTAR_PREFETCH=0` leaves out the software prefetches of the search
+ * loop, to measure what they gain.
+ */
+#ifndef ASTAR_PREFETCH
+#define ASTAR_PREFETCH 1
+#endif
+
+#if ASTAR_PREFETCH
+#define ASTAR_PREFETCH_READ(addr) __builtin_prefetch((addr), 0, 3)
+#else
+#define ASTAR_PREFETCH_READ(addr) ((void) 0)
+#endif
+
+/**
+ * @name                EdgeCostMode
+ * @details             The metric routes are planned on.
+ *
+ * COST_STATIC          The Manhattan length of the edge
+ * COST_LOAD            The length plus the same again for every `capacity`
+ *                      vehicles which entered the edge in the previous tick
+ */
+enum EdgeCostMode {
+    COST_STATIC,
+    COST_LOAD
+};
+
+extern EdgeCostMode edge_cost_mode;
+
+/**
+ * The loads COST_LOAD reads, indexed by Edge::id, usually VehicleTable::load
+ * of the simulation running in this process (see use_edge_loads).
+ */
+extern const int *edge_loads;
+
+/**
+ * @name                use_edge_loads
+ * @details             Makes edge_cost read the given loads. Pass NULL when the
+ *                      simulation is done; without loads every edge costs its
+ *                      length.
+ */
+void use_edge_loads(const int *loads);
+
+/**
+ * @name                parse_edge_cost_mode
+ * @details             Parses static or load.
+ *
+ * @return              false if the name is unknown
+ */
+bool parse_edge_cost_mode(const std::string &name, EdgeCostMode &mode);
+
+/**
+ * Cost policies of a_star_search. StaticCost and LoadCost fix the metric at
+ * compile time; EdgeCost follows edge_cost_mode.
+ */
+struct StaticCost {
+    static int cost(const Graph &graph, const Edge &edge) {
+        const Vertex &a = graph.vertices[edge.start];
+        const Vertex &b = graph.vertices[edge.end];
+        return abs(a.x - b.x) + abs(a.y - b.y);
+    }
+};
+
+struct LoadCost {
+    static int cost(const Graph &graph, const Edge &edge) {
+        int base = StaticCost::cost(graph, edge);
+        if (edge_loads == NULL || edge.capacity <= 0)
+            return base;
+        return base + base * edge_loads[edge.id] / edge.capacity;
+    }
+};
+
+/**
+ * @name                edge_cost
+ * @return              The cost of traversing edge under edge_cost_mode. Never
+ *                      below the Manhattan length, so the A* heuristic stays
+ *                      admissible.
+ */
+inline int edge_cost(const Graph &graph, const Edge &edge) {
+    if (edge_cost_mode == COST_STATIC)
+        return StaticCost::cost(graph, edge);
+    return LoadCost::cost(graph, edge);
+}
+
+struct EdgeCost {
+    static int cost(const Graph &graph, const Edge &edge) {
+        return edge_cost(graph, edge);
+    }
+};
+
+/**
+ * @name                pin_search_graph
+ * @details             Caches the minimum edge cost of the graph a simulation
+ *                      routes on, so the heuristic no longer scans every edge.
+ *                      Pass NULL when the simulation is done.
+ */
+void pin_search_graph(const Graph *graph);
+
+/**
+ * @name                search_min_edge_cost
+ * @return              The minimum base cost over all edges of the graph,
+ *                      from the cache if it is the pinned one
+ */
+int search_min_edge_cost(const Graph &graph);
+
+/**
+ * @name                HeapQueue
+ * @details             Binary heap with lazy deletion: a better key for a queued
+ *                      vertex is pushed as a second entry and the stale one is
+ *                      skipped when popped. Entries compare on the key alone,
+ *                      which reproduces the routes of the original float A*.
+ */
+class HeapQueue {
+    struct Entry {
+        int key;
+        int id;
+        bool operator>(const Entry &other) const {
+            return key > other.key;
+        }
+    };
+    // The heap algorithms std::priority_queue uses, on a vector which keeps
+    // its capacity from one search to the next.
+    std::vector<Entry> heap;
+
+public:
+    void reset(int) {
+        heap.clear();
+    }
+    bool empty() const {
+        return heap.empty();
+    }
+    void push(int v, int key) {
+        heap.push_back(Entry{key, v});
+        std::push_heap(heap.begin(), heap.end(), std::greater<Entry>());
+    }
+    void decrease(int v, int key) {
+        push(v, key);
+    }
+    // The vertex pop returns next, if it is known without work, else -1.
+    int peek() const {
+        return heap.empty() ? -1 : heap.front().id;
+    }
+    int pop() {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<Entry>());
+        int v = heap.back().id;
+        heap.pop_back();
+        return v;
+    }
+};
+
+/**
+ * @name                BucketQueue
+ * @details             Dial's bucket queue over integer keys. Each bucket is an
+ *                      intrusive doubly linked list threaded through per-vertex
+ *                      links, so a vertex is queued at most once and a better
+ *                      key moves it between buckets in O(1). The cursor only
+ *                      moves forward while keys are monotone; a smaller key
+ *                      (the heuristic is not consistent when the minimum edge
+ *                      cost exceeds 1) moves it back.
+ */
+class BucketQueue {
+    std::vector<int> head;      // first vertex of each key's bucket, or -1
+    std::vector<int> next, prev, key;
+    int cursor, lo, hi;
+    size_t count;
+
+    void link(int v, int k) {
+        if (k >= (int) head.size())
+            head.resize(std::max<size_t>(k + 1, head.size() * 2), -1);
+        key[v] = k;
+        prev[v] = -1;
+        next[v] = head[k];
+        if (next[v] >= 0)
+            prev[next[v]] = v;
+        head[k] = v;
+        cursor = std::min(cursor, k);
+        lo = std::min(lo, k);
+        hi = std::max(hi, k);
+        count++;
+    }
+    void unlink(int v) {
+        if (prev[v] >= 0)
+            next[prev[v]] = next[v];
+        else
+            head[key[v]] = next[v];
+        if (next[v] >= 0)
+            prev[next[v]] = prev[v];
+        count--;
+    }
+
+public:
+    BucketQueue() : cursor(0), lo(0), hi(-1), count(0) {}
+
+    void reset(int n) {
+        // Only the buckets the last search touched can be non-empty.
+        for (int k = lo; k <= hi; k++)
+            head[k] = -1;
+        if ((int) next.size() < n) {
+            next.resize(n);
+            prev.resize(n);
+            key.resize(n);
+        }
+        cursor = lo = INT_MAX;
+        hi = -1;
+        count = 0;
+    }
+    bool empty() const {
+        return count == 0;
+    }
+    void push(int v, int k) {
+        link(v, k);
+    }
+    void decrease(int v, int k) {
+        unlink(v);
+        link(v, k);
+    }
+    int peek() const {
+        return count > 0 ? head[cursor] : -1;
+    }
+    int pop() {
+        while (head[cursor] < 0)
+            cursor++;
+        int v = head[cursor];
+        unlink(v);
+        return v;
+    }
+};
+
+#if ASTAR_QUEUE == ASTAR_QUEUE_bucket
+typedef BucketQueue AStarQueue;
+#else
+typedef HeapQueue AStarQueue;
+#endif
+
+/**
+ * Heuristic policies of a_star_search, constructed once per search for its
+ * graph and goal.
+ *
+ * ManhattanHeuristic   The Manhattan distance times the minimum edge cost
+ * ZeroHeuristic        No estimate, which turns the search into Dijkstra's
+ */
+class ManhattanHeuristic {
+    int scale;
+    const Vertex &target;
+
+public:
+    ManhattanHeuristic(const Graph &graph, int goal)
+        : scale(search_min_edge_cost(graph)), target(graph.vertices[goal]) {}
+    int operator()(const Vertex &v) const {
+        return scale * (abs(v.x - target.x) + abs(v.y - target.y));
+    }
+};
+
+struct ZeroHeuristic {
+    ZeroHeuristic(const Graph &, int) {}
+    int operator()(const Vertex &) const {
+        return 0;
+    }
+};
+
+#if ASTAR_HEURISTIC == ASTAR_HEURISTIC_zero
+typedef ZeroHeuristic AStarHeuristic;
+#else
+typedef ManhattanHeuristic AStarHeuristic;
+#endif
+
+/**
+ * @name                SearchScratch
+ * @details             Per-thread search state reused across calls. A vertex's
+ *                      g and parent are only valid when its seen stamp matches
+ *                      the current epoch, so nothing is cleared between calls.
+ */
+struct SearchScratch {
+    std::vector<int> g;
+    std::vector<int> parent;
+    std::vector<uint32_t> seen;
+    std::vector<uint32_t> closed;
+    uint32_t epoch;
+
+    SearchScratch() : epoch(0) {}
+
+    void begin(int n) {
+        if ((int) seen.size() < n) {
+            g.resize(n);
+            parent.resize(n);
+            seen.resize(n, 0);
+            closed.resize(n, 0);
+        }
+        if (++epoch == 0) {
+            std::fill(seen.begin(), seen.end(), 0);
+            std::fill(closed.begin(), closed.end(), 0);
+            epoch = 1;
+        }
+    }
+};
+
+/**
+ * @name                a_star_search
+ * @details             A* on the integer edge costs of the Cost policy, guided
+ *                      by the Heuristic policy, over the open set Queue. The
+ *                      defaults are the edge_cost metric and the Manhattan
+ *                      distance times the minimum edge cost. Uses thread local
+ *                      scratch space, so it is safe to call from several OpenMP
+ *                      threads at once.
+ *
+ * @param[out] path     The route, including start and goal
+ * @param[in] avoidFrom, avoidTo  An edge the route must not use, or -1
+ * @param[in] weight    Scales the heuristic (weighted A*). Above 1 the search
+ *                      expands fewer vertices and the route may cost up to
+ *                      `weight` times more than with 1.
+ * @return              false if goal is unreachable
+ */
+template <class Queue, class Cost = EdgeCost, class Heuristic = AStarHeuristic>
+bool a_star_search(const Graph &graph, int start, int goal, std::vector<int> &path,
+                   int avoidFrom = -1, int avoidTo = -1, double weight = 1.0) {
+    // Bound once, so the thread local wrappers are not called in the loop.
+    static thread_local SearchScratch scratch;
+    static thread_local Queue queue;
+    SearchScratch &s = scratch;
+    Queue &open = queue;
+    int n = graph.vertices.size();
+    Heuristic h(graph, goal);
+    s.begin(n);
+    open.reset(n);
+
+    s.g[start] = 0;
+    s.parent[start] = -1;
+    s.seen[start] = s.epoch;
+    open.push(start, (int) (weight * h(graph.vertices[start])));
+    INSTR_COUNT(astar_calls, 1);
+    INSTR_COUNT(heap_pushes, 1);
+
+    while (!open.empty()) {
+        int current = open.pop();
+        if (current == goal) {
+            path.clear();
+            for (int cur = goal; cur != -1; cur = s.parent[cur])
+                path.push_back(cur);
+            std::reverse(path.begin(), path.end());
+            LOG_TRACE("[A*] Found route: " << path);
+            return true;
+        }
+        if (s.closed[current] == s.epoch)
+            continue;
+        s.closed[current] = s.epoch;
+        INSTR_COUNT(nodes_expanded, 1);
+        INSTR_NODE_READ(current);
+
+        // The neighbors are scattered over the vertex and search arrays;
+        // ask for all of them before the first relaxation waits on one.
+        const EdgeList &edges = graph.edges[current];
+        for (const Edge &edge : edges) {
+            int neighbor = (edge.start == current) ? edge.end : edge.start;
+            ASTAR_PREFETCH_READ(&graph.vertices[neighbor]);
+            ASTAR_PREFETCH_READ(&s.seen[neighbor]);
+        }
+
+        for (const Edge &edge : edges) {
+            int neighbor = (edge.start == current) ? edge.end : edge.start;
+            if (s.closed[neighbor] == s.epoch || !edge_open(edge) ||
+                (current == avoidFrom && neighbor == avoidTo))
+                continue;
+            int tentative = s.g[current] + Cost::cost(graph, edge);
+            bool queued = s.seen[neighbor] == s.epoch;
+            if (queued && tentative >= s.g[neighbor])
+                continue;
+            s.g[neighbor] = tentative;
+            s.parent[neighbor] = current;
+            s.seen[neighbor] = s.epoch;
+            int f = tentative + (int) (weight * h(graph.vertices[neighbor]));
+            if (queued)
+                open.decrease(neighbor, f);
+            else
+                open.push(neighbor, f);
+            INSTR_COUNT(heap_pushes, 1);
+        }
+
+        // Likely the next vertex expanded: its edge list loads while the
+        // queue pops.
+        int next = open.peek();
+        if (next >= 0)
+            ASTAR_PREFETCH_READ(graph.edges[next].data());
+    }
+    return false;
+}
+
+// The instantiations the engines use are compiled once, in astar.cpp, where
+// the optimizer gives the search loop its full attention.
+extern template bool a_star_search<AStarQueue, EdgeCost, AStarHeuristic>(
+    const Graph &, int, int, std::vector<int> &, int, int, double);
+extern template bool a_star_search<AStarQueue, StaticCost, AStarHeuristic>(
+    const Graph &, int, int, std::vector<int> &, int, int, double);
+extern template bool a_star_search<AStarQueue, LoadCost, AStarHeuristic>(
+    const Graph &, int, int, std::vector<int> &, int, int, double);
+
+#endif // ASTAR_H
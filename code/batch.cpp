@@ -0,0 +1,156 @@
+/**
+ *          15-418 Final Project
+ *          Title:  Congestion Aware Map Routing
+ *          Credit: Parth Iyer   (pniyer@andrew.cmu.edu)
+ *                  Kwaku Baryeh (kbaryeh@andrew.cmu.edu)
+ */
+
+#include "batch.h"
+#include "sequential.h"
+#include "log.h"
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <chrono>
+#include <map>
+#include <algorithm>
+#include <cstring>
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <omp.h>
+
+bool load_batch(const std::string &fname, std::vector<BatchScenario> &scenarios) {
+    std::ifstream file(fname.c_str());
+    if (!file.is_open()) {
+        LOG_ERROR("Unable to open scenario file " << fname);
+        return false;
+    }
+    scenarios.clear();
+    std::string line;
+    int lineNo = 0;
+    while (std::getline(file, line)) {
+        lineNo++;
+        std::stringstream ss(line);
+        BatchScenario s;
+        if (!(ss >> s.name) || s.name[0] == '#')
+            continue;
+        std::string demand, departures;
+        bool ok = (bool) (ss >> s.cars >> s.seed) && s.cars >= 0;
+        if (ok && ss >> demand)
+            ok = parse_demand_model(demand, s.workload.demand);
+        if (ok && ss >> departures)
+            ok = parse_departure_model(departures, s.workload.departures);
+        if (ok && !(ss >> s.workload.window) && !ss.eof())
+            ok = false;
+        if (!ok) {
+            LOG_ERROR(fname << ":" << lineNo << ": expected `name cars seed [demand] [departures] [window]`");
+            return false;
+        }
+        scenarios.push_back(s);
+    }
+    return true;
+}
+
+// --------------------------------------------------------------------
+// The body of a scenario's process; false if the scenario failed.
+static bool run_scenario(Problem &p, const BatchScenario &s, const SimOptions &opts, int threads) {
+    SimOptions scenario = opts;
+    scenario.output_file = opts.output_file + s.name + ".txt";
+    if (!opts.trace_file.empty())
+        scenario.trace_file = opts.trace_file + "." + s.name;
+    // Every scenario traces to a file of its own.
+    log_init(opts.log_level, scenario.trace_file);
+
+    omp_set_num_threads(threads);
+    if (s.cars > 0) {
+        srandom(s.seed);
+        generate_cars(p, s.cars, s.workload);
+    }
+
+    if (!opts.profile_file.empty())
+        scenario.profile_file = opts.profile_file + "." + s.name;
+    if (!opts.checkpoint_file.empty())
+        scenario.checkpoint_file = opts.checkpoint_file + "." + s.name;
+    LOG_INFO("Scenario " << s.name << ": " << (unsigned long) p.cars.size() << " cars on "
+             << threads << " threads");
+    return simulate_discrete_time(p, scenario);
+}
+
+int run_batch(Problem &p, const SimOptions &opts) {
+    std::vector<BatchScenario> scenarios;
+    if (!load_batch(opts.batch_file, scenarios))
+        return -1;
+    if (!opts.resume_file.empty()) {
+        LOG_ERROR("--resume cannot be combined with --batch");
+        return -1;
+    }
+    int jobs = std::max(1, opts.batch_jobs);
+    int threads = opts.threads > 0 ? opts.threads : std::max(1, omp_get_num_procs() / jobs);
+    LOG_INFO("Batch of " << (unsigned long) scenarios.size() << " scenarios on a graph of "
+             << (unsigned long) p.graph.vertices.size() << " vertices and " << p.graph.num_edges
+             << " edges: " << jobs << " at a time, " << threads << " threads each");
+
+    // The logger's thread does not survive fork(), so restart it in each child.
+    log_shutdown();
+    auto start_time = std::chrono::steady_clock::now();
+    std::map<pid_t, size_t> running;
+    std::vector<std::chrono::steady_clock::time_point> started(scenarios.size());
+    std::vector<double> seconds(scenarios.size(), 0);
+    std::vector<bool> ok(scenarios.size(), false);
+    size_t next = 0;
+    while (next < scenarios.size() || !running.empty()) {
+        // Keep `jobs` scenarios in flight.
+        while (next < scenarios.size() && (int) running.size() < jobs) {
+            started[next] = std::chrono::steady_clock::now();
+            pid_t pid = fork();
+            if (pid < 0) {
+                log_init(opts.log_level, "");
+                LOG_ERROR("fork failed: " << strerror(errno));
+                log_shutdown();
+                next = scenarios.size();
+                break;
+            }
+            if (pid == 0) {
+                bool done = run_scenario(p, scenarios[next], opts, threads);
+                log_shutdown();
+                _exit(done ? 0 : 1);
+            }
+            running[pid] = next++;
+        }
+        if (running.empty())
+            break;
+
+        int status;
+        pid_t pid = waitpid(-1, &status, 0);
+        if (pid < 0)
+            break;
+        auto it = running.find(pid);
+        if (it == running.end())
+            continue;
+        size_t k = it->second;
+        running.erase(it);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - started[k];
+        seconds[k] = elapsed.count();
+        ok[k] = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    }
+    std::chrono::duration<double> wall = std::chrono::steady_clock::now() - start_time;
+    log_init(opts.log_level, "");
+
+    int failed = 0;
+    double total = 0;
+    for (size_t k = 0; k < scenarios.size(); k++) {
+        total += seconds[k];
+        if (!ok[k]) {
+            failed++;
+            LOG_ERROR("Scenario " << scenarios[k].name << " failed");
+        } else {
+            LOG_INFO("Scenario " << scenarios[k].name << " took " << seconds[k] << " seconds");
+        }
+    }
+    std::cout << "Batch of " << scenarios.size() << " scenarios completed in " << wall.count()
+              << " seconds (" << total << " seconds of scenarios, " << failed << " failed)."
+              << std::endl;
+    return failed;
+}
@@ -0,0 +1,64 @@
+/**
+ *          15-418 Final Project
+ *          Title:  Congestion Aware Map Routing
+ *          Credit: Parth Iyer   (pniyer@andrew.cmu.edu)
+ *                  Kwaku Baryeh (kbaryeh@andrew.cmu.edu)
+ */
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "graph.h"
+#include "generator.h"
+#include "options.h"
+#include <string>
+#include <vector>
+
+/**
+ * @name                BatchScenario
+ * @details             One simulation of a batch: the graph of the loaded
+ *                      problem with its own set of cars.
+ *
+ * @param name          Names the scenario's output files
+ * @param cars          The number of cars to generate, or 0 to simulate the
+ *                      cars of the problem file
+ * @param seed          The generator seed
+ * @param workload      The demand and departure models of the generated cars
+ */
+struct BatchScenario {
+    std::string name;
+    int cars;
+    long seed;
+    WorkloadOptions workload;
+};
+
+/**
+ * @name                load_batch
+ * @details             Reads a scenario file with one scenario per line:
+ *                      `name cars seed [demand] [departures] [window]`. Blank
+ *                      lines and lines starting with # are skipped.
+ *
+ * @return              false (after logging the line) if the file is missing
+ *                      or a line is malformed
+ */
+bool load_batch(const std::string &fname, std::vector<BatchScenario> &scenarios);
+
+/**
+ * @name                run_batch
+ * @details             Runs every scenario of opts.batch_file on the graph of
+ *                      p, which is loaded and parsed once. Each scenario runs in
+ *                      a forked process of its own with opts.threads OpenMP
+ *                      threads, at most opts.batch_jobs at a time. The graph is
+ *                      only written by --events, so the processes share its
+ *                      pages; each only allocates its own cars, vehicle table
+ *                      and edge loads, and copies the pages of the edges its
+ *                      events change. Scenario k writes its
+ *                      solution to opts.output_file + name + ".txt", and its
+ *                      trace, profile and checkpoints with ".name" appended.
+ *
+ * @return              The number of scenarios which failed, or -1 if the
+ *                      batch could not be started
+ */
+int run_batch(Problem &p, const SimOptions &opts);
+
+#endif // BATCH_H
@@ -0,0 +1,534 @@
+/**
+ *          15-418 Final Project
+ *          Title:  Congestion Aware Map Routing
+ *          Credit: Parth Iyer   (pniyer@andrew.cmu.edu)
+ *                  Kwaku Baryeh (kbaryeh@andrew.cmu.edu)
+ */
+
+#include "graph.h"
+#include "generator.h"
+#include "sequential.h"
+#include "simulation.h"
+#include "vehicles.h"
+#include "instrument.h"
+#include "oracle.h"
+#include "astar.h"
+#include <vector>
+#include <string>
+#include <map>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdio.h>
+#include <glob.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <linux/perf_event.h>
+
+#ifndef BENCH_OPT
+#define BENCH_OPT "unknown"
+#endif
+
+/**
+ * Benchmark driver. Runs micro-benchmarks of the hot functions in-process
+ * and end-to-end runs of ./test_sequential and ./test_parallel over a set of
+ * problems, then writes the results as CSV and/or JSON for plot_speedup.py
+ * and misses.py. Build it with optimisations, e.g. `make OPT=-O2 bench`.
+ *
+ * `./bench [--inputs a.test,b.test] [--generate V:C[:seed]] [--threads 1,2,4]
+ *          [--reps N] [--warmup N] [--micro-only | --e2e-only] [--oracle-budget MB]
+ *          [--csv FILE] [--json FILE] [--baseline FILE] [--threshold F]`
+ *
+ * With --baseline the medians are compared against a CSV written by an
+ * earlier run and every benchmark more than `threshold` (default 10%) slower
+ * is flagged; the exit status is 2 if anything regressed.
+ */
+
+struct BenchOptions {
+    std::vector<std::string> inputs;
+    std::vector<std::string> generate;
+    std::vector<int> threads;
+    int reps;
+    int warmup;
+    bool micro;
+    bool e2e;
+    std::string csv_file;
+    std::string json_file;
+    std::string baseline_file;
+    double threshold;
+    std::string bin_dir;
+    int oracle_budget_mb;
+
+    BenchOptions() : reps(5), warmup(1), micro(true), e2e(true), threshold(0.10), bin_dir("."),
+                     oracle_budget_mb(512) {}
+};
+
+struct BenchResult {
+    std::string benchmark;
+    std::string input;
+    int threads;
+    int reps;
+    double mean;
+    double median;
+    double stddev;
+    double min;
+    double max;
+    long long cache_misses;
+};
+
+typedef std::chrono::steady_clock Clock;
+
+static double seconds_since(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// --------------------------------------------------------------------
+// Summary statistics over the timed repetitions.
+static BenchResult summarize(const std::string &benchmark, const std::string &input, int threads,
+                             std::vector<double> samples, long long cacheMisses) {
+    BenchResult r;
+    r.benchmark = benchmark;
+    r.input = input;
+    r.threads = threads;
+    r.reps = samples.size();
+    r.cache_misses = cacheMisses;
+
+    std::sort(samples.begin(), samples.end());
+    double sum = 0;
+    for (double s : samples)
+        sum += s;
+    r.mean = sum / samples.size();
+    size_t mid = samples.size() / 2;
+    r.median = samples.size() % 2 ? samples[mid] : (samples[mid - 1] + samples[mid]) / 2;
+    double var = 0;
+    for (double s : samples)
+        var += (s - r.mean) * (s - r.mean);
+    r.stddev = samples.size() > 1 ? std::sqrt(var / (samples.size() - 1)) : 0;
+    r.min = samples.front();
+    r.max = samples.back();
+
+    printf("%-28s %-24s %3d thr  median %.6gs  mean %.6gs  sd %.6gs\n", benchmark.c_str(),
+           input.c_str(), threads, r.median, r.mean, r.stddev);
+    fflush(stdout);
+    return r;
+}
+
+static std::string base_name(const std::string &path) {
+    size_t slash = path.find_last_of('/');
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+// --------------------------------------------------------------------
+// Micro-benchmarks: load_problem, a single a_star, update_edge_loads_current
+// and one full simulation tick.
+static void run_micro(const BenchOptions &opts, std::string file, std::vector<BenchResult> &results) {
+    std::string name = base_name(file);
+    int runs = opts.warmup + opts.reps;
+    std::vector<double> samples;
+
+    Problem p;
+    for (int r = 0; r < runs; r++) {
+        Clock::time_point start = Clock::now();
+        p = load_problem(file);
+        if (r >= opts.warmup)
+            samples.push_back(seconds_since(start));
+    }
+    results.push_back(summarize("load_problem", name, 1, samples, -1));
+
+    int nVertices = p.graph.vertices.size();
+    if (nVertices < 2)
+        return;
+
+    // The same 64 queries every repetition; the sample is the time per query.
+    const int QUERIES = 64;
+    srandom(418);
+    std::vector<std::pair<int, int>> queries;
+    for (int q = 0; q < QUERIES; q++)
+        queries.push_back(std::make_pair(random() % nVertices, random() % nVertices));
+    samples.clear();
+    pin_search_graph(&p.graph);
+    for (int r = 0; r < runs; r++) {
+        std::vector<int> path;
+        Clock::time_point start = Clock::now();
+        for (const auto &q : queries) {
+            path.clear();
+            a_star(p.graph, q.first, q.second, path);
+        }
+        if (r >= opts.warmup)
+            samples.push_back(seconds_since(start) / QUERIES);
+    }
+    pin_search_graph(NULL);
+    results.push_back(summarize("a_star", name, 1, samples, -1));
+
+    // The all-pairs oracle, when it fits, and the same queries answered by it.
+    if (oracle_bytes(nVertices) <= ((size_t) opts.oracle_budget_mb << 20)) {
+        DistanceOracle oracle;
+        samples.clear();
+        for (int r = 0; r < runs; r++) {
+            Clock::time_point start = Clock::now();
+            build_distance_oracle(p.graph, oracle, APSP_AUTO);
+            if (r >= opts.warmup)
+                samples.push_back(seconds_since(start));
+        }
+        results.push_back(summarize("apsp_build", name, 1, samples, -1));
+
+        samples.clear();
+        for (int r = 0; r < runs; r++) {
+            std::vector<int> path;
+            Clock::time_point start = Clock::now();
+            for (const auto &q : queries)
+                oracle_route(oracle, q.first, q.second, path);
+            if (r >= opts.warmup)
+                samples.push_back(seconds_since(start) / QUERIES);
+        }
+        results.push_back(summarize("apsp_query", name, 1, samples, -1));
+    }
+
+    // One edge per car, as if every vehicle moved this tick.
+    VehicleTable vt;
+    init_vehicle_table(vt, p);
+    std::vector<VehicleShard> shards(1);
+    std::vector<EdgeRef> moves;
+    for (size_t i = 0; i < p.cars.size(); i++) {
+        int u = p.cars[i].src;
+        if (!p.graph.edges[u].empty())
+            moves.push_back({u, (int) (random() % p.graph.edges[u].size())});
+    }
+    samples.clear();
+    for (int r = 0; r < runs; r++) {
+        shards[0].moved = moves;
+        Clock::time_point start = Clock::now();
+        update_edge_loads_current(p.graph, vt, shards);
+        if (r >= opts.warmup)
+            samples.push_back(seconds_since(start));
+    }
+    results.push_back(summarize("update_edge_loads_current", name, 1, samples, -1));
+
+    // The first tick, where every vehicle plans its route.
+    samples.clear();
+    for (int r = 0; r < runs; r++) {
+        init_vehicle_table(vt, p);
+        shards[0].finished.clear();
+        Clock::time_point start = Clock::now();
+        for (int i : vt.active)
+            step_vehicle(p.graph, vt, shards[0], i, 0);
+        update_edge_loads_current(p.graph, vt, shards);
+        retire_vehicles(vt, shards);
+        if (r >= opts.warmup)
+            samples.push_back(seconds_since(start));
+    }
+    results.push_back(summarize("simulation_tick", name, 1, samples, -1));
+}
+
+// --------------------------------------------------------------------
+// One run of a simulation binary with its output discarded.
+static bool run_binary(const std::string &binary, const std::string &file, int threads,
+                       double &seconds, long long &cacheMisses) {
+    // Inherited by the child, so it counts the whole run.
+    int counter = perf_counter_open(PERF_COUNT_HW_CACHE_MISSES, true);
+
+    Clock::time_point start = Clock::now();
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        return false;
+    }
+    if (pid == 0) {
+        char buf[16];
+        snprintf(buf, sizeof(buf), "%d", threads);
+        setenv("OMP_NUM_THREADS", buf, 1);
+        // Keep the timing free of terminal output; failures show in the status.
+        int devnull = open("/dev/null", O_WRONLY);
+        dup2(devnull, STDOUT_FILENO);
+        dup2(devnull, STDERR_FILENO);
+        execl(binary.c_str(), binary.c_str(), file.c_str(), "--log-level", "error",
+              "--output", "/dev/null", (char *) NULL);
+        _exit(127);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    seconds = seconds_since(start);
+    cacheMisses = perf_counter_read(counter);
+    if (counter >= 0)
+        close(counter);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        fprintf(stderr, "%s %s failed\n", binary.c_str(), file.c_str());
+        return false;
+    }
+    return true;
+}
+
+static bool run_e2e(const BenchOptions &opts, const std::string &file, const std::string &engine,
+                    int threads, std::vector<BenchResult> &results) {
+    std::string binary = opts.bin_dir + "/test_" + engine;
+    std::vector<double> samples;
+    long long misses = 0;
+    for (int r = 0; r < opts.warmup + opts.reps; r++) {
+        double seconds;
+        long long runMisses;
+        if (!run_binary(binary, file, threads, seconds, runMisses))
+            return false;
+        if (r < opts.warmup)
+            continue;
+        samples.push_back(seconds);
+        misses = (runMisses < 0 || misses < 0) ? -1 : misses + runMisses;
+    }
+    results.push_back(summarize(engine, base_name(file), threads, samples,
+                                misses < 0 ? -1 : misses / opts.reps));
+    return true;
+}
+
+// --------------------------------------------------------------------
+// Writes generated problems next to the system temporary files.
+static std::string generate_input(const std::string &spec) {
+    int vertices = 0, cars = 0, seed = 1;
+    if (sscanf(spec.c_str(), "%d:%d:%d", &vertices, &cars, &seed) < 2 || vertices < 2) {
+        fprintf(stderr, "Bad --generate spec %s, expected V:C[:seed]\n", spec.c_str());
+        return "";
+    }
+    const char *tmp = getenv("TMPDIR");
+    char fname[512];
+    snprintf(fname, sizeof(fname), "%s/bench_%d_%d_%d.test", tmp ? tmp : "/tmp", vertices, cars, seed);
+    if (access(fname, R_OK) == 0)
+        return fname;
+
+    srandom(seed);
+    Problem p = generate_problem(vertices, cars);
+    FILE *out = fopen(fname, "w");
+    if (out == NULL) {
+        perror(fname);
+        return "";
+    }
+    save_problem(p, out);
+    fclose(out);
+    return fname;
+}
+
+// --------------------------------------------------------------------
+// Output and baseline comparison.
+static const char *CSV_HEADER =
+    "benchmark,input,threads,reps,mean_s,median_s,stddev_s,min_s,max_s,cache_misses";
+
+static bool write_csv(const std::string &fname, const std::vector<BenchResult> &results) {
+    FILE *out = fopen(fname.c_str(), "w");
+    if (out == NULL) {
+        perror(fname.c_str());
+        return false;
+    }
+    fprintf(out, "%s\n", CSV_HEADER);
+    for (const BenchResult &r : results)
+        fprintf(out, "%s,%s,%d,%d,%.9g,%.9g,%.9g,%.9g,%.9g,%lld\n", r.benchmark.c_str(),
+                r.input.c_str(), r.threads, r.reps, r.mean, r.median, r.stddev, r.min, r.max,
+                r.cache_misses);
+    fclose(out);
+    return true;
+}
+
+static bool write_json(const std::string &fname, const std::vector<BenchResult> &results) {
+    FILE *out = fopen(fname.c_str(), "w");
+    if (out == NULL) {
+        perror(fname.c_str());
+        return false;
+    }
+    char host[256] = "";
+    gethostname(host, sizeof(host) - 1);
+    fprintf(out, "{\n  \"host\": \"%s\",\n  \"cpus\": %ld,\n  \"opt\": \"%s\",\n  \"results\": [\n",
+            host, sysconf(_SC_NPROCESSORS_ONLN), BENCH_OPT);
+    for (size_t k = 0; k < results.size(); k++) {
+        const BenchResult &r = results[k];
+        fprintf(out, "    {\"benchmark\": \"%s\", \"input\": \"%s\", \"threads\": %d, \"reps\": %d, "
+                "\"mean_s\": %.9g, \"median_s\": %.9g, \"stddev_s\": %.9g, \"min_s\": %.9g, "
+                "\"max_s\": %.9g, \"cache_misses\": %lld}%s\n", r.benchmark.c_str(), r.input.c_str(),
+                r.threads, r.reps, r.mean, r.median, r.stddev, r.min, r.max, r.cache_misses,
+                k + 1 < results.size() ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+    fclose(out);
+    return true;
+}
+
+static std::string result_key(const std::string &benchmark, const std::string &input, int threads) {
+    return benchmark + "|" + input + "|" + std::to_string(threads);
+}
+
+// Returns the number of regressions, or -1 if the baseline cannot be read.
+static int compare_baseline(const std::string &fname, const std::vector<BenchResult> &results,
+                            double threshold) {
+    std::ifstream in(fname);
+    if (!in) {
+        fprintf(stderr, "Unable to read baseline %s\n", fname.c_str());
+        return -1;
+    }
+    std::map<std::string, double> baseline;
+    std::string line;
+    std::getline(in, line);
+    while (std::getline(in, line)) {
+        std::stringstream ss(line);
+        std::string benchmark, input, threads, reps, mean, median;
+        std::getline(ss, benchmark, ',');
+        std::getline(ss, input, ',');
+        std::getline(ss, threads, ',');
+        std::getline(ss, reps, ',');
+        std::getline(ss, mean, ',');
+        std::getline(ss, median, ',');
+        if (!median.empty())
+            baseline[result_key(benchmark, input, atoi(threads.c_str()))] = atof(median.c_str());
+    }
+
+    int regressions = 0;
+    printf("\nComparison against %s (threshold %.0f%%)\n", fname.c_str(), threshold * 100);
+    for (const BenchResult &r : results) {
+        auto it = baseline.find(result_key(r.benchmark, r.input, r.threads));
+        if (it == baseline.end() || it->second <= 0)
+            continue;
+        double change = r.median / it->second - 1;
+        const char *flag = "";
+        if (change > threshold) {
+            flag = "  REGRESSION";
+            regressions++;
+        } else if (change < -threshold) {
+            flag = "  improved";
+        }
+        printf("%-28s %-24s %3d thr  %+7.1f%%%s\n", r.benchmark.c_str(), r.input.c_str(),
+               r.threads, change * 100, flag);
+    }
+    return regressions;
+}
+
+// --------------------------------------------------------------------
+static std::vector<std::string> split_list(const char *arg) {
+    std::vector<std::string> items;
+    std::stringstream ss(arg);
+    std::string item;
+    while (std::getline(ss, item, ','))
+        if (!item.empty())
+            items.push_back(item);
+    return items;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [options]\n", prog);
+    fprintf(stderr, "  --inputs A,B        problem files (default inputs/*.test)\n");
+    fprintf(stderr, "  --generate V:C[:S]  also benchmark a generated problem, may repeat\n");
+    fprintf(stderr, "  --threads 1,2,4     thread counts for test_parallel (default powers of 2 up to #cpus)\n");
+    fprintf(stderr, "  --reps N            timed repetitions (default 5)\n");
+    fprintf(stderr, "  --warmup N          untimed repetitions first (default 1)\n");
+    fprintf(stderr, "  --micro-only        only the micro-benchmarks\n");
+    fprintf(stderr, "  --oracle-budget MB  benchmark the all-pairs oracle up to this size (default 512, 0 skips)\n");
+    fprintf(stderr, "  --e2e-only          only the end-to-end runs\n");
+    fprintf(stderr, "  --bin-dir DIR       where test_sequential and test_parallel are (default .)\n");
+    fprintf(stderr, "  --csv FILE          write results as CSV\n");
+    fprintf(stderr, "  --json FILE         write results as JSON\n");
+    fprintf(stderr, "  --baseline FILE     compare medians with an earlier CSV\n");
+    fprintf(stderr, "  --threshold F       relative slowdown counted as a regression (default 0.10)\n");
+}
+
+static bool parse_bench_options(int argc, char *argv[], BenchOptions &opts) {
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (strcmp(arg, "--inputs") == 0 && hasValue) {
+            opts.inputs = split_list(argv[++i]);
+        } else if (strcmp(arg, "--generate") == 0 && hasValue) {
+            opts.generate.push_back(argv[++i]);
+        } else if (strcmp(arg, "--threads") == 0 && hasValue) {
+            opts.threads.clear();
+            for (const std::string &t : split_list(argv[++i]))
+                opts.threads.push_back(atoi(t.c_str()));
+        } else if (strcmp(arg, "--reps") == 0 && hasValue) {
+            opts.reps = atoi(argv[++i]);
+        } else if (strcmp(arg, "--warmup") == 0 && hasValue) {
+            opts.warmup = atoi(argv[++i]);
+        } else if (strcmp(arg, "--oracle-budget") == 0 && hasValue) {
+            opts.oracle_budget_mb = atoi(argv[++i]);
+        } else if (strcmp(arg, "--micro-only") == 0) {
+            opts.e2e = false;
+        } else if (strcmp(arg, "--e2e-only") == 0) {
+            opts.micro = false;
+        } else if (strcmp(arg, "--bin-dir") == 0 && hasValue) {
+            opts.bin_dir = argv[++i];
+        } else if (strcmp(arg, "--csv") == 0 && hasValue) {
+            opts.csv_file = argv[++i];
+        } else if (strcmp(arg, "--json") == 0 && hasValue) {
+            opts.json_file = argv[++i];
+        } else if (strcmp(arg, "--baseline") == 0 && hasValue) {
+            opts.baseline_file = argv[++i];
+        } else if (strcmp(arg, "--threshold") == 0 && hasValue) {
+            opts.threshold = atof(argv[++i]);
+        } else {
+            usage(argv[0]);
+            return false;
+        }
+    }
+    if (opts.reps < 1 || opts.warmup < 0) {
+        fprintf(stderr, "--reps must be at least 1 and --warmup at least 0\n");
+        return false;
+    }
+
+    if (opts.inputs.empty() && opts.generate.empty()) {
+        glob_t g;
+        if (glob("inputs/*.test", 0, NULL, &g) == 0) {
+            for (size_t k = 0; k < g.gl_pathc; k++)
+                opts.inputs.push_back(g.gl_pathv[k]);
+            globfree(&g);
+        }
+    }
+    for (const std::string &spec : opts.generate) {
+        std::string fname = generate_input(spec);
+        if (fname.empty())
+            return false;
+        opts.inputs.push_back(fname);
+    }
+    if (opts.inputs.empty()) {
+        fprintf(stderr, "No inputs to benchmark\n");
+        return false;
+    }
+
+    if (opts.threads.empty()) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        for (int t = 1; t < cpus; t *= 2)
+            opts.threads.push_back(t);
+        opts.threads.push_back(cpus < 1 ? 1 : cpus);
+    }
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    BenchOptions opts;
+    if (!parse_bench_options(argc, argv, opts))
+        return 1;
+
+    std::vector<BenchResult> results;
+    for (const std::string &file : opts.inputs) {
+        if (opts.micro)
+            run_micro(opts, file, results);
+        if (opts.e2e) {
+            if (!run_e2e(opts, file, "sequential", 1, results))
+                return 1;
+            for (int t : opts.threads)
+                if (!run_e2e(opts, file, "parallel", t, results))
+                    return 1;
+        }
+    }
+
+    if (!opts.csv_file.empty() && !write_csv(opts.csv_file, results))
+        return 1;
+    if (!opts.json_file.empty() && !write_json(opts.json_file, results))
+        return 1;
+
+    if (!opts.baseline_file.empty()) {
+        int regressions = compare_baseline(opts.baseline_file, results, opts.threshold);
+        if (regressions < 0)
+            return 1;
+        if (regressions > 0) {
+            printf("%d benchmark(s) regressed\n", regressions);
+            return 2;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,224 @@
+/**
+ *          15-418 Final Project
+ *          Title:  Congestion Aware Map Routing
+ *          Credit: Parth Iyer   (pniyer@andrew.cmu.edu)
+ *                  Kwaku Baryeh (kbaryeh@andrew.cmu.edu)
+ */
+
+#include "checkpoint.h"
+#include "log.h"
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <algorithm>
+#include <stdio.h>
+#include <unistd.h>
+
+// The first bytes of every checkpoint file, without a terminator.
+static const char CHECKPOINT_MAGIC[] = {'R', 'T', 'C', '2'};
+static const int32_t CHECKPOINT_VERSION = 3;
+
+// --------------------------------------------------------------------
+// Flat little helpers for the checkpoint layout. Everything is raw 32/64 bit
+// integers so both writing and reading are straight memory copies.
+
+static void put_i32(std::vector<uint8_t> &out, int32_t v) {
+    const uint8_t *b = (const uint8_t *) &v;
+    out.insert(out.end(), b, b + sizeof(v));
+}
+
+static void put_i64(std::vector<uint8_t> &out, int64_t v) {
+    const uint8_t *b = (const uint8_t *) &v;
+    out.insert(out.end(), b, b + sizeof(v));
+}
+
+template <typename V>
+static void put_array(std::vector<uint8_t> &out, const V &values) {
+    put_i64(out, values.size());
+    const uint8_t *b = (const uint8_t *) values.data();
+    out.insert(out.end(), b, b + values.size() * sizeof(values[0]));
+}
+
+struct Reader {
+    const uint8_t *data;
+    size_t size;
+    size_t pos;
+
+    bool get(void *dst, size_t len) {
+        if (pos + len > size)
+            return false;
+        memcpy(dst, data + pos, len);
+        pos += len;
+        return true;
+    }
+
+    template <typename V>
+    bool get_array(V &values) {
+        int64_t n;
+        if (!get(&n, sizeof(n)) || n < 0 || (size_t) n > size)
+            return false;
+        values.resize(n);
+        return get(values.data(), n * sizeof(values[0]));
+    }
+};
+
+// --------------------------------------------------------------------
+
+static int64_t count_edges(const Graph &graph) {
+    int64_t n = 0;
+    for (const auto &list : graph.edges)
+        n += list.size();
+    return n;
+}
+
+static void write_file(std::string fname, std::vector<uint8_t> *buffer) {
+    std::string tmp = fname + ".tmp";
+    FILE *f = fopen(tmp.c_str(), "wb");
+    if (f == NULL) {
+        LOG_ERROR("Unable to write checkpoint " << tmp);
+        return;
+    }
+    bool ok = fwrite(buffer->data(), 1, buffer->size(), f) == buffer->size();
+    ok = fflush(f) == 0 && ok;
+    ok = fsync(fileno(f)) == 0 && ok;
+    fclose(f);
+    if (!ok || rename(tmp.c_str(), fname.c_str()) != 0)
+        LOG_ERROR("Failed to write checkpoint " << fname);
+}
+
+void init_checkpointer(Checkpointer &c, const std::string &fname, int every) {
+    c.fname = fname;
+    c.every = fname.empty() ? 0 : every;
+}
+
+void maybe_checkpoint(Checkpointer &c, int tick, const Graph &graph, const VehicleTable &t,
+                      SolutionWriter &writer) {
+    if (c.every <= 0 || tick % c.every != 0)
+        return;
+    finish_checkpoints(c);
+
+    long solutionSize = sync_solution_writer(writer);
+    std::vector<uint8_t> &out = c.buffer;
+    out.assign(CHECKPOINT_MAGIC, CHECKPOINT_MAGIC + sizeof(CHECKPOINT_MAGIC));
+    put_i32(out, CHECKPOINT_VERSION);
+    put_i64(out, graph.vertices.size());
+    put_i64(out, count_edges(graph));
+    put_i64(out, t.position.size());
+    put_i32(out, tick);
+    put_i64(out, solutionSize);
+    put_i64(out, writer.written);
+
+    put_array(out, t.position);
+    put_array(out, t.cursor);
+    put_array(out, t.waited);
+    put_array(out, t.held);
+    put_array(out, t.done);
+    put_array(out, t.active);
+    put_i32(out, t.remaining);
+
+    // Finished vehicles have been streamed out, so only active vehicles carry
+    // a route and a partial trajectory.
+    for (int i : t.active) {
+        put_array(out, t.route[i]);
+        put_array(out, t.path[i]);
+    }
+
+    // Only edges loaded in the last tick are non-zero.
+    std::vector<int32_t> loads;
+    for (const EdgeRef &e : t.loaded) {
+        loads.push_back(e.vertex);
+        loads.push_back(e.local);
+        loads.push_back(t.load[graph.edges[e.vertex][e.local].id]);
+    }
+    put_array(out, loads);
+
+    c.worker = std::thread(write_file, c.fname, &c.buffer);
+    LOG_INFO("Checkpoint at tick " << tick << " (" << (unsigned long) out.size() << " bytes)");
+}
+
+void finish_checkpoints(Checkpointer &c) {
+    if (c.worker.joinable())
+        c.worker.join();
+}
+
+bool load_checkpoint(const std::string &fname, const Graph &graph, VehicleTable &t, SimCheckpoint &cp) {
+    std::ifstream file(fname.c_str(), std::ios::binary);
+    if (!file.is_open()) {
+        LOG_ERROR("Unable to open checkpoint " << fname);
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    std::string data = buffer.str();
+    Reader r = {(const uint8_t *) data.data(), data.size(), 0};
+
+    char magic[sizeof(CHECKPOINT_MAGIC)];
+    int32_t version, tick, remaining;
+    int64_t nVertices, nEdges, nVehicles, solutionSize, written;
+    if (!r.get(magic, sizeof(magic)) || memcmp(magic, CHECKPOINT_MAGIC, sizeof(magic)) != 0 ||
+        !r.get(&version, sizeof(version)) || version != CHECKPOINT_VERSION) {
+        LOG_ERROR(fname << " is not a checkpoint file");
+        return false;
+    }
+    if (!r.get(&nVertices, sizeof(nVertices)) || !r.get(&nEdges, sizeof(nEdges)) ||
+        !r.get(&nVehicles, sizeof(nVehicles))) {
+        LOG_ERROR("Checkpoint " << fname << " is truncated");
+        return false;
+    }
+    if (nVertices != (int64_t) graph.vertices.size() || nEdges != count_edges(graph) ||
+        nVehicles != (int64_t) t.position.size()) {
+        LOG_ERROR("Checkpoint " << fname << " was taken for a different problem");
+        return false;
+    }
+
+    bool ok = r.get(&tick, sizeof(tick)) && r.get(&solutionSize, sizeof(solutionSize)) &&
+              r.get(&written, sizeof(written)) &&
+              r.get_array(t.position) && r.get_array(t.cursor) && r.get_array(t.waited) && r.get_array(t.held) &&
+              r.get_array(t.done) && r.get_array(t.active) && r.get(&remaining, sizeof(remaining));
+    // Every per-vehicle array is indexed by vehicle id below.
+    ok = ok && (int64_t) t.position.size() == nVehicles && (int64_t) t.cursor.size() == nVehicles &&
+         (int64_t) t.waited.size() == nVehicles && (int64_t) t.held.size() == nVehicles &&
+         (int64_t) t.done.size() == nVehicles;
+    for (size_t k = 0; ok && k < t.active.size(); k++) {
+        int i = t.active[k];
+        ok = i >= 0 && i < nVehicles && r.get_array(t.route[i]) && r.get_array(t.path[i]);
+    }
+    std::vector<int32_t> loads;
+    ok = ok && r.get_array(loads) && loads.size() % 3 == 0;
+    if (!ok) {
+        LOG_ERROR("Checkpoint " << fname << " is truncated or corrupt");
+        return false;
+    }
+
+    // Finished vehicles are already in the solution file.
+    for (int i = 0; i < nVehicles; i++) {
+        t.slot[i] = -1;
+        if (t.done[i]) {
+            std::vector<uint8_t>().swap(t.route[i]);
+            std::vector<uint8_t>().swap(t.path[i]);
+        }
+    }
+    for (size_t k = 0; k < t.active.size(); k++)
+        t.slot[t.active[k]] = k;
+    // Vehicles still waiting to depart are not in the file; requeue them.
+    seek_departures(t, tick);
+    t.remaining = remaining;
+
+    std::fill(t.load.begin(), t.load.end(), 0);
+    t.loaded.clear();
+    for (size_t k = 0; k < loads.size(); k += 3) {
+        EdgeRef e = {loads[k], loads[k + 1]};
+        if (e.vertex < 0 || e.vertex >= nVertices || e.local < 0 ||
+            e.local >= (int) graph.edges[e.vertex].size()) {
+            LOG_ERROR("Checkpoint " << fname << " names an edge which does not exist");
+            return false;
+        }
+        t.load[graph.edges[e.vertex][e.local].id] = loads[k + 2];
+        t.loaded.push_back(e);
+    }
+
+    cp.tick = tick;
+    cp.solutionSize = solutionSize;
+    cp.written = written;
+    return true;
+}
@@ -0,0 +1,85 @@
+/**
+ *          15-418 Final Project
+ *          Title:  Congestion Aware Map Routing
+ *          Credit: Parth Iyer   (pniyer@andrew.cmu.edu)
+ *                  Kwaku Baryeh (kbaryeh@andrew.cmu.edu)
+ */
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "graph.h"
+#include "vehicles.h"
+#include "solution_writer.h"
+#include <string>
+#include <vector>
+#include <thread>
+#include <stdint.h>
+
+/**
+ * @name                SimCheckpoint
+ * @details             Simulation state restored from a checkpoint file.
+ *
+ * @param tick          The tick the simulation resumes at
+ * @param solutionSize  Offset of the end of the solution file at that tick
+ * @param written       Number of paths in the solution file at that tick
+ */
+struct SimCheckpoint {
+    int tick;
+    long solutionSize;
+    size_t written;
+};
+
+/**
+ * @name                Checkpointer
+ * @details             Writes checkpoints in the background. The simulation
+ *                      thread only pays for flattening the state into `buffer`;
+ *                      the file is written (to a temporary name which is then
+ *                      renamed over the old checkpoint) by `worker`.
+ *
+ * @param fname         The checkpoint file
+ * @param every         Take a checkpoint every this many ticks (0 disables)
+ * @param buffer        The flattened state being written
+ * @param worker        The thread writing `buffer`, if any
+ */
+struct Checkpointer {
+    std::string fname;
+    int every;
+    std::vector<uint8_t> buffer;
+    std::thread worker;
+};
+
+/**
+ * @name                init_checkpointer
+ * @details             Sets up checkpoints to `fname` every `every` ticks.
+ */
+void init_checkpointer(Checkpointer &c, const std::string &fname, int every);
+
+/**
+ * @name                maybe_checkpoint
+ * @details             Takes a checkpoint when `tick` is a multiple of the
+ *                      interval. Waits for the previous checkpoint to finish
+ *                      writing and for the solution writer to catch up, then
+ *                      snapshots the tick, the vehicle table and the edge loads
+ *                      and hands the snapshot to the background thread.
+ */
+void maybe_checkpoint(Checkpointer &c, int tick, const Graph &graph, const VehicleTable &t,
+                      SolutionWriter &writer);
+
+/**
+ * @name                finish_checkpoints
+ * @details             Waits for the last checkpoint to be written.
+ */
+void finish_checkpoints(Checkpointer &c);
+
+/**
+ * @name                load_checkpoint
+ * @details             Restores the vehicle table and the edge loads from a
+ *                      checkpoint written for the same problem.
+ *
+ * @return              false if the file is missing, corrupt or belongs to a
+ *                      different problem
+ */
+bool load_checkpoint(const std::string &fname, const Graph &graph, VehicleTable &t, SimCheckpoint &cp);
+
+#endif // CHECKPOINT_H
@@ -237,13 +237,9 @@ bool a_star(const Graph &graph, int start, int goal, vector<int> &path) {
 // Update the loads on edges based only on the moves made in the current tick.
 // This function uses the 'prevPositions' and 'currentPositions' vectors
 // so that it reflects only the vehicles that are currently traversing an edge.
-void update_edge_loads_current(Graph &graph, const vector<int> &prevPositions, const vector<int> &currentPositions) {
+void update_edge_loads_current(const Graph &graph, vector<int> &load, const vector<int> &prevPositions, const vector<int> &currentPositions) {
     // Reset loads for all edges.
-    for (auto &edgeList : graph.edges) {
-        for (auto &edge : edgeList) {
-            edge.load = 0;
-        }
-    }
+    std::fill(load.begin(), load.end(), 0);
     // For each vehicle, update the load for the edge taken in this tick.
     for (size_t i = 0; i < currentPositions.size(); i++) {
         int u = prevPositions[i];
@@ -253,7 +249,7 @@ void update_edge_loads_current(Graph &graph, const vector<int> &prevPositions, c
             const Edge &edge = graph.edges[u][localIdx];
             if ((edge.start == u && edge.end == v) || (edge.start == v && edge.end == u)) {
                 // Increase the load by 1 for this tick.
-                graph.edges[u][localIdx].load++;
+                load[edge.id]++;
                 foundEdge = true;
                 break;
             }
@@ -277,6 +273,7 @@ void simulate_discrete_time(Problem &p) {
     vector<vector<int>> overallPaths(numVehicles);  // overall movement histories
     vector<vector<int>> vehicleRoutes(numVehicles);  // current planned routes
     vector<bool> reachedDestination(numVehicles, false);
+    vector<int> load(p.graph.num_edges, 0);  // Edge loads of the current tick, by Edge::id.
 
     // Initialize starting positions.
     for (int i = 0; i < numVehicles; i++) {
@@ -311,8 +308,8 @@ void simulate_discrete_time(Problem &p) {
                         edgeFound = true;
                         //std::cerr << "[DEBUG] Vehicle " << i << " sees edge from " << currentPosition[i]
                         //     << " to " << nextNode << ": base cost = " << computeManhattanCost(p.graph, edge)
-                        //     << ", load = " << edge.load << ", capacity = " << edge.capacity << std::endl;
-                        if (edge.load < edge.capacity) {
+                        //     << ", load = " << load[edge.id] << ", capacity = " << edge.capacity << std::endl;
+                        if (load[edge.id] < edge.capacity) {
                             canProceed = true;
                         }
                         break;
@@ -359,7 +356,7 @@ void simulate_discrete_time(Problem &p) {
         }
         
         // Update edge loads based only on the moves of this tick.
-        update_edge_loads_current(p.graph, prevPositions, currentPosition);
+        update_edge_loads_current(p.graph, load, prevPositions, currentPosition);
         
         // Print current positions.
         // std::cerr << "After tick " << tick << ", vehicle positions:" << std::endl;
@@ -0,0 +1,385 @@
+/**
+ *          15-418 Final Project
+ *          Title:  Congestion Aware Map Routing
+ *          Credit: Parth Iyer   (pniyer@andrew.cmu.edu)
+ *                  Kwaku Baryeh (kbaryeh@andrew.cmu.edu)
+ */
+
+#include "distributed.h"
+#include "partition.h"
+#include "simulation.h"
+#include "vehicles.h"
+#include "solution_writer.h"
+#include "log.h"
+#include "astar.h"
+#include <vector>
+#include <algorithm>
+#include <string>
+#include <chrono>
+#include <cstring>
+#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+// --------------------------------------------------------------------
+// Message encoding. Messages are flat int32 arrays prefixed (on the wire) with
+// their int64 byte length.
+
+static void put_i32(std::vector<uint8_t> &out, int32_t v) {
+    const uint8_t *b = (const uint8_t *) &v;
+    out.insert(out.end(), b, b + sizeof(v));
+}
+
+static int32_t get_i32(const std::vector<uint8_t> &in, size_t &pos) {
+    int32_t v = 0;
+    if (pos + sizeof(v) <= in.size())
+        memcpy(&v, in.data() + pos, sizeof(v));
+    pos += sizeof(v);
+    return v;
+}
+
+// Appends vehicle i's position, the hops left on its route and the hops of
+// its path so far.
+static void pack_vehicle(std::vector<uint8_t> &out, VehicleTable &vt, int i) {
+    put_i32(out, i);
+    put_i32(out, vt.position[i]);
+    put_i32(out, vt.route[i].size() - vt.cursor[i]);
+    out.insert(out.end(), vt.route[i].begin() + vt.cursor[i], vt.route[i].end());
+    put_i32(out, vt.path[i].size());
+    out.insert(out.end(), vt.path[i].begin(), vt.path[i].end());
+    std::vector<uint8_t>().swap(vt.route[i]);
+    std::vector<uint8_t>().swap(vt.path[i]);
+}
+
+static void unpack_vehicle(const std::vector<uint8_t> &in, size_t &pos, VehicleTable &vt) {
+    int i = get_i32(in, pos);
+    vt.position[i] = get_i32(in, pos);
+    int len = get_i32(in, pos);
+    vt.route[i].assign(in.begin() + pos, in.begin() + pos + len);
+    pos += len;
+    vt.cursor[i] = 0;
+    len = get_i32(in, pos);
+    vt.path[i].assign(in.begin() + pos, in.begin() + pos + len);
+    pos += len;
+    activate_vehicle(vt, i);
+}
+
+// --------------------------------------------------------------------
+// All-to-all exchange: sends out[peer] to and receives in[peer] from every
+// peer. Non-blocking sockets and poll() keep two ranks that both send large
+// messages from deadlocking on full socket buffers.
+static bool exchange(const std::vector<int> &fds, std::vector<std::vector<uint8_t>> &out,
+                     std::vector<std::vector<uint8_t>> &in) {
+    int ranks = fds.size();
+    std::vector<size_t> sent(ranks, 0), received(ranks, 0);
+    std::vector<int64_t> sendLen(ranks), recvLen(ranks, -1);
+    int pending = 0;
+    for (int r = 0; r < ranks; r++) {
+        if (fds[r] < 0)
+            continue;
+        sendLen[r] = out[r].size();
+        out[r].insert(out[r].begin(), (uint8_t *) &sendLen[r], (uint8_t *) &sendLen[r] + sizeof(int64_t));
+        in[r].resize(sizeof(int64_t));
+        pending += 2;
+    }
+
+    std::vector<pollfd> pfds;
+    std::vector<int> peer;
+    while (pending > 0) {
+        pfds.clear();
+        peer.clear();
+        for (int r = 0; r < ranks; r++) {
+            if (fds[r] < 0)
+                continue;
+            short events = 0;
+            if (sent[r] < out[r].size())
+                events |= POLLOUT;
+            if (received[r] < in[r].size())
+                events |= POLLIN;
+            if (events != 0) {
+                pfds.push_back({fds[r], events, 0});
+                peer.push_back(r);
+            }
+        }
+        if (poll(pfds.data(), pfds.size(), -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        for (size_t k = 0; k < pfds.size(); k++) {
+            int r = peer[k];
+            if (pfds[k].revents & (POLLERR | POLLNVAL))
+                return false;
+            if (pfds[k].revents & POLLOUT) {
+                ssize_t n = send(fds[r], out[r].data() + sent[r], out[r].size() - sent[r], MSG_NOSIGNAL);
+                if (n < 0 && errno != EAGAIN && errno != EINTR)
+                    return false;
+                if (n > 0 && (sent[r] += n) == out[r].size())
+                    pending--;
+            }
+            if (pfds[k].revents & (POLLIN | POLLHUP)) {
+                ssize_t n = recv(fds[r], in[r].data() + received[r], in[r].size() - received[r], 0);
+                if (n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR))
+                    return false;
+                if (n > 0)
+                    received[r] += n;
+                if (recvLen[r] < 0 && received[r] == sizeof(int64_t)) {
+                    memcpy(&recvLen[r], in[r].data(), sizeof(int64_t));
+                    in[r].resize(sizeof(int64_t) + recvLen[r]);
+                }
+                if (recvLen[r] >= 0 && received[r] == in[r].size())
+                    pending--;
+            }
+        }
+    }
+
+    for (int r = 0; r < ranks; r++) {
+        if (fds[r] < 0)
+            continue;
+        in[r].erase(in[r].begin(), in[r].begin() + sizeof(int64_t));
+        out[r].clear();
+    }
+    return true;
+}
+
+// --------------------------------------------------------------------
+// The simulation loop of one rank.
+static bool run_rank(Problem &p, int rank, const std::vector<int> &region, const std::vector<int> &fds,
+                     const SimOptions &opts, const std::string &partFile) {
+    int ranks = fds.size();
+    VehicleTable vt;
+    init_vehicle_table(vt, p);
+    use_edge_loads(vt.load.data());
+    for (int i = 0; i < (int) p.cars.size(); i++) {
+        if (region[vt.position[i]] != rank) {
+            if (vt.slot[i] >= 0)
+                deactivate_vehicle(vt, i);
+            else
+                vt.remaining--;  // Departs later, from another rank's region.
+            std::vector<uint8_t>().swap(vt.path[i]);
+        }
+    }
+    vt.departures.erase(std::remove_if(vt.departures.begin(), vt.departures.end(),
+                                       [&](int i) { return region[vt.position[i]] != rank; }),
+                        vt.departures.end());
+
+    SolutionWriter writer;
+    if (!open_solution_writer(writer, p.graph, partFile, opts.output_format)) {
+        LOG_ERROR("Rank " << rank << " failed to open " << partFile);
+        return false;
+    }
+
+    std::vector<VehicleShard> shards(1);
+    std::vector<std::vector<uint8_t>> out(ranks), in(ranks);
+    long globalRemaining = p.cars.size();
+    long moves = 0, migrated = 0;
+    int tick = 0;
+    int lastDeparture = 0;
+    for (const Car &c : p.cars)
+        lastDeparture = std::max(lastDeparture, c.depart);
+    int tickLimit = 100000 + lastDeparture;
+    while (globalRemaining > 0) {
+        // Ranks stay in lock step, so idle ticks are not skipped here.
+        release_departures(vt, tick);
+        for (size_t k = 0; k < vt.active.size(); k++)
+            step_vehicle(p.graph, vt, shards[0], vt.active[k], tick);
+
+        moves += shards[0].moved.size();
+        update_edge_loads_current(p.graph, vt, shards);
+        refresh_route_metric(p.graph, vt);
+        stream_finished(writer, vt, shards);
+        retire_vehicles(vt, shards);
+
+        // Hand vehicles which crossed a region boundary to their new owner.
+        std::vector<int> migrants(ranks, 0);
+        for (int k = (int) vt.active.size() - 1; k >= 0; k--) {
+            int i = vt.active[k];
+            int owner = region[vt.position[i]];
+            if (owner != rank) {
+                if (migrants[owner]++ == 0)
+                    put_i32(out[owner], 0);  // Placeholder for the migrant count.
+                pack_vehicle(out[owner], vt, i);
+                deactivate_vehicle(vt, i);
+            }
+        }
+        long total = vt.remaining;
+        for (int r = 0; r < ranks; r++) {
+            if (r == rank)
+                continue;
+            if (migrants[r] == 0)
+                put_i32(out[r], 0);
+            memcpy(out[r].data(), &migrants[r], sizeof(int32_t));
+            total += migrants[r];
+            migrated += migrants[r];
+        }
+        for (int r = 0; r < ranks; r++) {
+            if (r != rank) {
+                int64_t t = total;
+                const uint8_t *b = (const uint8_t *) &t;
+                out[r].insert(out[r].end(), b, b + sizeof(t));
+            }
+        }
+
+        if (!exchange(fds, out, in)) {
+            LOG_ERROR("Rank " << rank << " lost contact with its peers");
+            // Join the writer's thread; the part file is not merged anyway.
+            close_solution_writer(writer, vt);
+            return false;
+        }
+
+        globalRemaining = total;
+        for (int r = 0; r < ranks; r++) {
+            if (r == rank)
+                continue;
+            size_t pos = 0;
+            int count = get_i32(in[r], pos);
+            for (int m = 0; m < count; m++)
+                unpack_vehicle(in[r], pos, vt);
+            int64_t theirs = 0;
+            if (pos + sizeof(theirs) <= in[r].size())
+                memcpy(&theirs, in[r].data() + pos, sizeof(theirs));
+            globalRemaining += theirs;
+        }
+
+        tick++;
+        if (tick > tickLimit) break;  // Safety limit, reached by every rank at the same tick.
+    }
+
+    close_solution_writer(writer, vt);
+    LOG_INFO("Rank " << rank << ": " << tick << " ticks, " << moves << " moves, "
+             << migrated << " vehicles migrated out");
+    report_weighted_routing();
+    return true;
+}
+
+// --------------------------------------------------------------------
+// Concatenates the rank outputs into one solution file.
+static bool merge_parts(const std::string &outputFile, const std::vector<std::string> &parts,
+                        SolutionFormat format) {
+    FILE *out = fopen(outputFile.c_str(), "wb");
+    if (out == NULL)
+        return false;
+    size_t magic = strlen(SOLUTION_MAGIC);
+    if (format == FORMAT_BINARY)
+        fwrite(SOLUTION_MAGIC, 1, magic, out);
+    std::vector<char> buf(1 << 20);
+    for (const std::string &part : parts) {
+        FILE *in = fopen(part.c_str(), "rb");
+        if (in == NULL) {
+            fclose(out);
+            return false;
+        }
+        if (format == FORMAT_BINARY)
+            fseek(in, magic, SEEK_SET);
+        size_t n;
+        while ((n = fread(buf.data(), 1, buf.size(), in)) > 0)
+            fwrite(buf.data(), 1, n, out);
+        fclose(in);
+        unlink(part.c_str());
+    }
+    fclose(out);
+    return true;
+}
+
+double simulate_distributed(Problem &p, const SimOptions &opts) {
+    // Every rank would need the events and an index of the routes it holds.
+    if (!opts.events_file.empty()) {
+        LOG_ERROR("--events is not supported by the distributed simulation");
+        return -1;
+    }
+    int ranks = opts.ranks < 1 ? 1 : opts.ranks;
+    std::vector<int> region = partition_by_coordinates(p.graph, ranks);
+    LOG_INFO("Partitioned " << (unsigned long) p.graph.vertices.size() << " vertices into " << ranks
+             << " regions, " << count_cut_edges(p.graph, region) << " cut edges");
+
+    // One socket pair per pair of ranks.
+    std::vector<std::vector<int>> fds(ranks, std::vector<int>(ranks, -1));
+    for (int a = 0; a < ranks; a++) {
+        for (int b = a + 1; b < ranks; b++) {
+            int sv[2];
+            if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) {
+                LOG_ERROR("socketpair failed: " << strerror(errno));
+                return -1;
+            }
+            fcntl(sv[0], F_SETFL, O_NONBLOCK);
+            fcntl(sv[1], F_SETFL, O_NONBLOCK);
+            fds[a][b] = sv[0];
+            fds[b][a] = sv[1];
+        }
+    }
+
+    std::string outputFile = opts.output_file.empty() ? "log_distributed.txt" : opts.output_file;
+    std::vector<std::string> parts;
+    for (int r = 0; r < ranks; r++)
+        parts.push_back(outputFile + ".rank" + std::to_string(r));
+
+    // An oracle is built once here and shared copy-on-write by the ranks.
+    DistanceOracle oracle;
+    if (select_router(p.graph, opts, oracle))
+        use_distance_oracle(&oracle);
+    parse_edge_cost_mode(opts.edge_cost, edge_cost_mode);
+    OverlayGraph overlay;
+    if (select_overlay(p.graph, opts, overlay))
+        use_overlay(&overlay);
+    pin_search_graph(&p.graph);
+    use_reroute_policy(opts.reroute_slack);
+    use_weighted_routing(opts.epsilon, opts.gap_audit, false);
+
+    // The logger's thread does not survive fork(), so restart it in each child.
+    log_shutdown();
+    auto start_time = std::chrono::steady_clock::now();
+    std::vector<pid_t> children;
+    for (int r = 0; r < ranks; r++) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            LOG_ERROR("fork failed: " << strerror(errno));
+            break;
+        }
+        if (pid == 0) {
+            log_init(opts.log_level, opts.trace_file.empty() ? "" : opts.trace_file + ".rank" + std::to_string(r));
+            for (int a = 0; a < ranks; a++)
+                for (int b = 0; b < ranks; b++)
+                    if (a != r && fds[a][b] >= 0)
+                        close(fds[a][b]);
+            bool ok = run_rank(p, r, region, fds[r], opts, parts[r]);
+            log_shutdown();
+            _exit(ok ? 0 : 1);
+        }
+        children.push_back(pid);
+    }
+    for (auto &row : fds)
+        for (int fd : row)
+            if (fd >= 0)
+                close(fd);
+
+    bool ok = (int) children.size() == ranks;
+    for (pid_t pid : children) {
+        int status;
+        waitpid(pid, &status, 0);
+        ok = ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    }
+    auto end_time = std::chrono::steady_clock::now();
+    use_distance_oracle(NULL);
+    pin_search_graph(NULL);
+    use_reroute_policy(-1);
+    use_weighted_routing(0, 0, false);
+    use_overlay(NULL);
+    edge_cost_mode = COST_STATIC;
+    log_init(opts.log_level, "");
+
+    if (!ok) {
+        LOG_ERROR("A rank failed; no solution written");
+        return -1;
+    }
+    if (!merge_parts(outputFile, parts, opts.output_format)) {
+        LOG_ERROR("Failed to write " << outputFile);
+        return -1;
+    }
+    LOG_INFO("Saved solution to " << outputFile);
+    std::chrono::duration<double> elapsed = end_time - start_time;
+    return elapsed.count();
+}
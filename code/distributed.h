@@ -0,0 +1,42 @@
+/**
+ *          15-418 Final Project
+ *          Title:  Congestion Aware Map Routing
+ *          Credit: Parth Iyer   (pniyer@andrew.cmu.edu)
+ *                  Kwaku Baryeh (kbaryeh@andrew.cmu.edu)
+ */
+
+#ifndef DISTRIBUTED_H
+#define DISTRIBUTED_H
+
+#include "graph.h"
+#include "options.h"
+
+/**
+ * @name                simulate_distributed
+ * @details             Domain decomposed simulation. The graph is split into
+ *                      `opts.ranks` regions by coordinate bisection and one
+ *                      process is forked per region. Every process keeps the
+ *                      (copy-on-write shared) graph but only steps the vehicles
+ *                      currently inside its region. A vehicle only ever reads
+ *                      the load of an edge leaving its current vertex, and that
+ *                      load is produced by the rank owning the vertex, so the
+ *                      result is identical to the single process simulation.
+ *
+ *                      Between ticks every pair of ranks exchanges one message
+ *                      over a Unix domain socket: the vehicles that crossed
+ *                      into the receiver's region plus the sender's count of
+ *                      vehicles still en route. The exchange doubles as the
+ *                      tick barrier and every rank sums the counts to decide
+ *                      termination on its own.
+ *
+ *                      Each rank streams its finished paths to
+ *                      `<output>.rank<k>`; the parent concatenates them. With
+ *                      --trace FILE each rank traces to `FILE.rank<k>`.
+ *
+ * @param[in] p         The problem; the parent's copy is never modified
+ * @param[in] opts      Options, `opts.ranks` is the number of processes
+ * @return              Wall clock seconds of the simulation, or -1 on failure
+ */
+double simulate_distributed(Problem &p, const SimOptions &opts);
+
+#endif // DISTRIBUTED_H
@@ -0,0 +1,89 @@
+/**
+ *          15-418 Final Project
+ *          Title:  Congestion Aware Map Routing
+ *          Credit: Parth Iyer   (pniyer@andrew.cmu.edu)
+ *                  Kwaku Baryeh (kbaryeh@andrew.cmu.edu)
+ */
+
+#ifndef ENCODING_H
+#define ENCODING_H
+
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @name                put_varint
+ * @details             Appends an unsigned LEB128 varint (7 bits per byte,
+ *                      high bit set on every byte but the last).
+ */
+inline void put_varint(std::vector<uint8_t> &out, uint32_t v) {
+    while (v >= 0x80) {
+        out.push_back((uint8_t) (v | 0x80));
+        v >>= 7;
+    }
+    out.push_back((uint8_t) v);
+}
+
+/**
+ * @name                get_varint
+ * @details             Decodes a varint starting at data[pos] and advances pos.
+ *                      Returns false if the input ends inside the varint.
+ */
+inline bool get_varint(const uint8_t *data, size_t size, size_t &pos, uint32_t &v) {
+    v = 0;
+    for (int shift = 0; shift < 35 && pos < size; shift += 7) {
+        uint8_t b = data[pos++];
+        v |= (uint32_t) (b & 0x7f) << shift;
+        if ((b & 0x80) == 0)
+            return true;
+    }
+    return false;
+}
+
+/**
+ * @name                zigzag
+ * @details             Maps signed deltas onto unsigned values so that small
+ *                      magnitudes of either sign encode in few varint bytes.
+ */
+inline uint32_t zigzag(int32_t v) {
+    return ((uint32_t) v << 1) ^ (uint32_t) (v >> 31);
+}
+
+inline int32_t unzigzag(uint32_t v) {
+    return (int32_t) (v >> 1) ^ -(int32_t) (v & 1);
+}
+
+/**
+ * @name                put_hop
+ * @details             Appends one hop of a route: the index of the edge taken
+ *                      within its start vertex's edge list. Indices below
+ *                      HOP_ESCAPE take one byte; larger ones are HOP_ESCAPE
+ *                      followed by a varint of the excess.
+ */
+const uint8_t HOP_ESCAPE = 255;
+
+inline void put_hop(std::vector<uint8_t> &out, int local) {
+    if (local < HOP_ESCAPE) {
+        out.push_back((uint8_t) local);
+        return;
+    }
+    out.push_back(HOP_ESCAPE);
+    put_varint(out, local - HOP_ESCAPE);
+}
+
+/**
+ * @name                get_hop
+ * @details             Decodes the hop at data[pos] and advances pos past it.
+ *                      The hops must have been written by put_hop.
+ */
+inline int get_hop(const uint8_t *data, size_t &pos) {
+    uint8_t b = data[pos++];
+    if (b != HOP_ESCAPE)
+        return b;
+    uint32_t excess;
+    get_varint(data, SIZE_MAX, pos, excess);
+    return HOP_ESCAPE + (int) excess;
+}
+
+#endif // ENCODING_H
@@ -0,0 +1,453 @@
+/**
+ *          15-418 Final Project
+ *          Title:  Congestion Aware Map Routing
+ *          Credit: Parth Iyer   (pniyer@andrew.cmu.edu)
+ *                  Kwaku Baryeh (kbaryeh@andrew.cmu.edu)
+ */
+
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include "graph.h"
+#include "options.h"
+#include "vehicles.h"
+#include "simulation.h"
+#include "checkpoint.h"
+#include "events.h"
+#include "gridlock.h"
+#include "alternatives.h"
+#include "numa.h"
+#include "instrument.h"
+#include "astar.h"
+#include "log.h"
+#include <vector>
+#include <string>
+#include <chrono>
+#include <iostream>
+#include <omp.h>
+
+/**
+ * The simulation loop shared by test_sequential and test_parallel, as a
+ * template over policies:
+ *
+ * Executor             How the vehicles of a tick are spread over threads
+ *                      (SerialExecutor or OpenMPExecutor)
+ * Queue                The A* open set (see AStarQueue)
+ * Heuristic            The A* heuristic (see AStarHeuristic)
+ *
+ * The cost model is picked from --edge-cost when the simulation starts, among
+ * instantiations of A* with StaticCost and LoadCost, and the log level is
+ * fixed at compile time by LOG_COMPILE_LEVEL. A variant for an experiment is a
+ * new instantiation of simulate_engine, not a new copy of the loop.
+ */
+
+/**
+ * @name                SerialExecutor
+ * @details             Runs everything on the calling thread.
+ */
+struct SerialExecutor {
+    // Detours are only worth searching ahead when other threads are idle.
+    static const bool speculates = false;
+
+    static int workers() {
+        return 1;
+    }
+
+    // Calls body(k, worker) for k in [0, n).
+    template <class Body>
+    static void step(int n, Body body) {
+        INSTR_TIME(busy_ns);
+        for (int k = 0; k < n; k++)
+            body(k, 0);
+    }
+
+    // Like step, over the slots numa.order groups by node.
+    template <class Body>
+    static void step_placed(NumaPlacement &numa, Body body) {
+        INSTR_TIME(busy_ns);
+        int begin, count;
+        for (int d = 0; d < numa.topology.nodes(); d++) {
+            int node = (numa.worker_node[0] + d) % numa.topology.nodes();
+            while ((count = claim_slots(numa, node, begin)) > 0) {
+                for (int j = begin; j < begin + count; j++)
+                    body(numa.order[j], 0);
+                (d == 0 ? numa.local_steps : numa.stolen_steps) += count;
+            }
+        }
+    }
+
+    template <class Body>
+    static void for_each(int n, Body body) {
+        for (int k = 0; k < n; k++)
+            body(k, 0);
+    }
+
+    // Calls body(worker) once on every worker.
+    template <class Body>
+    static void on_workers(Body body) {
+        body(0);
+    }
+
+    // Runs serial() and then body(k) for k in [0, n).
+    template <class Serial, class Body>
+    static void overlap(Serial serial, int n, Body body) {
+        serial();
+        for (int k = 0; k < n; k++)
+            body(k);
+    }
+};
+
+/**
+ * @name                OpenMPExecutor
+ * @details             Spreads the vehicles over the OpenMP threads, each with
+ *                      its own shard, and overlaps the serial output phase with
+ *                      the speculative detour searches.
+ */
+struct OpenMPExecutor {
+    static const bool speculates = true;
+
+    static int workers() {
+        return omp_get_max_threads();
+    }
+
+    // Each thread's busy time ends when it runs out of vehicles, before the
+    // closing barrier.
+    template <class Body>
+    static void step(int n, Body body) {
+        #pragma omp parallel
+        {
+            INSTR_TIME(busy_ns);
+            #pragma omp for schedule(dynamic) nowait
+            for (int k = 0; k < n; k++)
+                body(k, omp_get_thread_num());
+        }
+    }
+
+    // Each worker claims the vehicles in its own node's region first and
+    // then helps the other nodes, nearest ids first.
+    template <class Body>
+    static void step_placed(NumaPlacement &numa, Body body) {
+        #pragma omp parallel
+        {
+            INSTR_TIME(busy_ns);
+            int worker = omp_get_thread_num();
+            int nodes = numa.topology.nodes();
+            unsigned long local = 0, stolen = 0;
+            int begin, count;
+            for (int d = 0; d < nodes; d++) {
+                int node = (numa.worker_node[worker] + d) % nodes;
+                while ((count = claim_slots(numa, node, begin)) > 0) {
+                    for (int j = begin; j < begin + count; j++)
+                        body(numa.order[j], worker);
+                    (d == 0 ? local : stolen) += count;
+                }
+            }
+            numa.local_steps += local;
+            numa.stolen_steps += stolen;
+        }
+    }
+
+    template <class Body>
+    static void for_each(int n, Body body) {
+        #pragma omp parallel for schedule(static)
+        for (int k = 0; k < n; k++)
+            body(k, omp_get_thread_num());
+    }
+
+    template <class Body>
+    static void on_workers(Body body) {
+        #pragma omp parallel
+        body(omp_get_thread_num());
+    }
+
+    // One thread runs serial() while the others start on the bodies, and
+    // joins them when it is done.
+    template <class Serial, class Body>
+    static void overlap(Serial serial, int n, Body body) {
+        #pragma omp parallel if (n > 0)
+        {
+            #pragma omp single nowait
+            serial();
+            #pragma omp for schedule(dynamic) nowait
+            for (int k = 0; k < n; k++)
+                body(k);
+        }
+    }
+};
+
+/**
+ * @name                simulate_engine
+ * @details             Simulation with transient (current tick only) edge
+ *                      loads. Only the vehicles in the table's active list are
+ *                      visited each tick; the workers record their moves and
+ *                      finished vehicles in their own padded shard, and the
+ *                      shards are merged serially afterwards. Paths are
+ *                      streamed to opts.output_file, or defaultOutput, as
+ *                      vehicles finish. The events of opts.events_file are
+ *                      applied to p.graph as their ticks come up, and stay
+ *                      applied when the simulation returns. Vehicles waiting
+ *                      in a ring are dealt with by opts.gridlock; only the
+ *                      abort policy ends the simulation early.
+ *                      With opts.alternatives, departing vehicles on popular
+ *                      trips are spread over alternative routes.
+ *
+ * @return              false if the simulation could not start, or stopped
+ *                      with vehicles en route (on a gridlock or the tick
+ *                      limit)
+ */
+template <class Executor, class Queue, class Heuristic>
+bool simulate_engine(Problem &p, const SimOptions &opts, const char *defaultOutput) {
+    auto start_time = std::chrono::steady_clock::now();
+    VehicleTable vt;
+    init_vehicle_table(vt, p);
+    instrument_init(opts.profile_file, opts.perf_counters);
+
+    // Pin the workers and move each region's edge lists to its node.
+    NumaPlacement numa;
+    int numaMode = 0;
+    parse_numa_mode(opts.numa, numaMode);
+    bool placed = init_numa_placement(numa, p.graph, numaMode, Executor::workers());
+    if (placed) {
+        Executor::on_workers([&](int worker) {
+            place_worker(numa, p.graph, worker);
+        });
+        instrument_vertex_node = numa.region.data();
+    }
+
+    // Optionally pick up where a checkpoint left off.
+    SimCheckpoint resume = {0, -1, 0};
+    if (!opts.resume_file.empty()) {
+        if (!load_checkpoint(opts.resume_file, p.graph, vt, resume))
+            return false;
+        LOG_INFO("Resuming from " << opts.resume_file << " at tick " << resume.tick);
+    }
+
+    // Read the events before the writer's thread starts, so a bad file
+    // stops the run cleanly.
+    EdgeEvents events;
+    bool haveEvents = !opts.events_file.empty();
+    if (haveEvents && !load_edge_events(opts.events_file, p.graph, events))
+        return false;
+
+    // Finished vehicles are streamed to the solution file while we simulate.
+    std::string outputFile = opts.output_file.empty() ? defaultOutput : opts.output_file;
+    SolutionWriter writer;
+    if (!open_solution_writer(writer, p.graph, outputFile, opts.output_format, resume.solutionSize, resume.written)) {
+        LOG_ERROR("Failed to open " << outputFile << " for writing!");
+        return false;
+    }
+    Checkpointer checkpointer;
+    init_checkpointer(checkpointer, opts.checkpoint_file, opts.checkpoint_every);
+    std::vector<VehicleShard> shards(Executor::workers());
+
+    // Either A* per query or an all-pairs table built up front.
+    DistanceOracle oracle;
+    if (select_router(p.graph, opts, oracle))
+        use_distance_oracle(&oracle);
+    parse_edge_cost_mode(opts.edge_cost, edge_cost_mode);
+    OverlayGraph overlay;
+    if (select_overlay(p.graph, opts, overlay))
+        use_overlay(&overlay);
+    if (edge_cost_mode == COST_LOAD)
+        use_route_search(a_star_search<Queue, LoadCost, Heuristic>);
+    else
+        use_route_search(a_star_search<Queue, StaticCost, Heuristic>);
+    pin_search_graph(&p.graph);
+    use_edge_loads(vt.load.data());
+    use_reroute_policy(opts.reroute_slack);
+    use_weighted_routing(opts.epsilon, opts.gap_audit, opts.route_budget_us > 0);
+    // The events before the resume tick were applied to the graph, and the
+    // routes in the checkpoint already avoid them.
+    if (haveEvents && resume.tick > 0)
+        apply_edge_events(p.graph, vt, events, resume.tick - 1, false);
+    GridlockDetector gridlock;
+    GridlockPolicy gridlockPolicy = GRIDLOCK_OFF;
+    parse_gridlock_policy(opts.gridlock, gridlockPolicy);
+    init_gridlock_detector(gridlock, p.graph, vt, shards.size(), gridlockPolicy, opts.gridlock_after);
+    use_gridlock_policy(gridlockPolicy == GRIDLOCK_OFF ? 0 : opts.gridlock_after);
+    // Alternatives for the popular trips, generated a group per worker.
+    AlternativeRoutes alternatives;
+    bool spread = opts.alternatives >= 2;
+    if (spread) {
+        auto altStart = std::chrono::steady_clock::now();
+        int groups = group_trips(alternatives, p.graph, vt, opts.alternatives, opts.alt_stretch);
+        Executor::for_each(groups, [&](int g, int) {
+            generate_alternatives(alternatives, p.graph, g);
+        });
+        alternatives.build_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - altStart).count();
+    }
+    SpeculativeReroutes spec;
+    bool speculate = Executor::speculates && opts.reroute_slack >= 0 && opts.speculate;
+    if (speculate)
+        use_speculation(&spec);
+
+    // The safety limit counts from the last departure.
+    int tickLimit = 100000 + (vt.departures.empty() ? 0 : vt.depart[vt.departures.back()]);
+    int tick = resume.tick;
+    // The vehicles active from the start depart now too, unless resuming.
+    size_t departed = resume.tick > 0 ? vt.active.size() : 0;
+    while (vt.remaining > 0) {
+        // Vehicles join the active list on their departure tick.
+        tick = skip_idle_ticks(vt, tick);
+        release_departures(vt, tick);
+        if (spread && departed < vt.active.size()) {
+            INSTR_PHASE(PHASE_STEP);
+            int pending = queue_departures(alternatives, vt, departed);
+            Executor::for_each(pending, [&](int k, int) {
+                plan_direct(alternatives, p.graph, vt, k);
+            });
+            assign_alternatives(alternatives, p.graph, vt);
+        }
+        LOG_DEBUG("Tick " << tick << ":");
+        if (haveEvents) {
+            INSTR_PHASE(PHASE_STEP);
+            apply_edge_events(p.graph, vt, events, tick, true);
+        }
+        int numActive = vt.active.size();
+
+        // Process each vehicle still en route.
+        {
+            INSTR_PHASE(PHASE_STEP);
+            auto stepOne = [&](int k, int worker) {
+                step_vehicle(p.graph, vt, shards[worker], vt.active[k], tick);
+            };
+            if (placed) {
+                schedule_by_region(numa, vt);
+                Executor::step_placed(numa, stepOne);
+            } else {
+                Executor::step(numActive, stepOne);
+            }
+        }
+
+        // Spend the refinement budget on exact routes for the vehicles which
+        // got weighted ones, while the loads are unchanged.
+        if (opts.route_budget_us > 0) {
+            INSTR_PHASE(PHASE_STEP);
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(opts.route_budget_us);
+            refine_routes(p.graph, vt, shards, deadline,
+                          Executor::workers() > 1);
+        }
+
+        // Look for rings in the wait-for graph of the vehicles blocked for a
+        // while, and route them out, or stop if asked to. Either way this
+        // tick's entries are kept for the next tick's arcs.
+        bool gridlocked = false;
+        if (gridlock.policy != GRIDLOCK_OFF) {
+            INSTR_PHASE(PHASE_STEP);
+            if (collect_blocked(gridlock, p.graph, vt, shards) > 0) {
+                Executor::for_each(shards.size(), [&](int w, int) {
+                    link_blocked(gridlock, w);
+                });
+                if (find_gridlocks(gridlock, vt, tick) > 0) {
+                    if (gridlock.policy == GRIDLOCK_REPLAN) {
+                        Executor::for_each(gridlock.members.size(), [&](int k, int) {
+                            gridlock.resolved[k] = replan_around(p.graph, vt, gridlock.members[k], tick);
+                        });
+                        count_replanned(gridlock);
+                    }
+                    gridlocked = gridlock.policy == GRIDLOCK_ABORT;
+                }
+            }
+            Executor::for_each(shards.size(), [&](int w, int) {
+                track_entries(gridlock, p.graph, shards, w);
+            });
+        }
+        if (haveEvents) {
+            INSTR_PHASE(PHASE_STEP);
+            index_routes(events, p.graph, vt);
+        }
+
+        // Update edge loads based only on the moves of this tick.
+        {
+            INSTR_PHASE(PHASE_LOADS);
+            update_edge_loads_current(p.graph, vt, shards);
+            refresh_route_metric(p.graph, vt);
+        }
+
+        // The loads of the next tick are known now, so are the vehicles which
+        // will find their next edge full. Their detours are searched while
+        // this tick is written out.
+        int numSpec = 0;
+        if (speculate) {
+            Executor::for_each(numActive, [&](int k, int worker) {
+                nominate_detour(p.graph, vt, shards[worker], vt.active[k]);
+            });
+            numSpec = collect_speculation(spec, p.graph, vt, shards);
+        }
+        Executor::overlap([&]() {
+#if LOG_COMPILE_LEVEL >= LOG_LEVEL_TRACE
+            // Print the positions of the vehicles still en route.
+            if (log_enabled(LOG_LEVEL_TRACE)) {
+                LOG_TRACE("After tick " << tick << ", vehicle positions:");
+                for (int i : vt.active)
+                    LOG_TRACE("Vehicle " << i << " is at node " << vt.position[i]
+                              << (vt.position[i] == vt.dest[i] ? " [DEST]" : ""));
+            }
+#endif
+
+            // Hand finished paths to the writer and swap the vehicles out of the active list.
+            INSTR_PHASE(PHASE_OUTPUT);
+            stream_finished(writer, vt, shards);
+            retire_vehicles(vt, shards);
+        }, numSpec, [&](int k) {
+            run_speculation(p.graph, spec, k);
+        });
+        departed = vt.active.size();
+        INSTR_END_TICK(tick, numActive);
+        if (gridlocked) {
+            LOG_ERROR("Stopping after tick " << tick << " on a gridlock, with "
+                      << vt.remaining << " vehicles en route");
+            break;
+        }
+        tick++;
+        if (tick > tickLimit) break;  // Safety limit.
+
+        INSTR_PHASE(PHASE_OUTPUT);
+        maybe_checkpoint(checkpointer, tick, p.graph, vt, writer);
+    }
+    finish_checkpoints(checkpointer);
+    instrument_finish();
+    use_distance_oracle(NULL);
+    pin_search_graph(NULL);
+    use_edge_loads(NULL);
+    use_route_search(NULL);
+    use_reroute_policy(-1);
+    report_weighted_routing();
+    use_weighted_routing(0, 0, false);
+    use_overlay(NULL);
+    refresh_route_topology(p.graph, std::vector<EdgeRef>(), 0);
+    report_edge_events(events);
+    use_gridlock_policy(0);
+    report_gridlocks(gridlock);
+    report_alternatives(alternatives);
+    if (placed) {
+        Executor::on_workers([&](int worker) {
+            unpin_worker(numa, worker);
+        });
+        instrument_vertex_node = NULL;
+        report_numa_placement(numa);
+    }
+    GraphArenaStats arena = graph_arena_stats();
+    if (arena.chunks > 0)
+        LOG_INFO("Graph arena: " << arena.used / 1048576.0 << " MB used of " << arena.mapped / 1048576.0
+                 << " MB in " << (unsigned long) arena.chunks << " chunks on " << std::max(arena.nodes, 1)
+                 << " nodes, " << arena.huge / 1048576.0
+                 << " MB on huge pages");
+    edge_cost_mode = COST_STATIC;
+    use_speculation(NULL);
+    if (speculate)
+        LOG_INFO("Speculative detours: " << (unsigned long) spec.used << " used, "
+                 << (unsigned long) spec.discarded << " discarded");
+
+    // Write out the vehicles the tick limit cut off and wait for the writer.
+    bool finished = vt.remaining == 0;
+    size_t written = close_solution_writer(writer, vt);
+    LOG_INFO("Saved " << (unsigned long) written << " paths to " << outputFile);
+    auto end_time = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed = end_time - start_time;
+    std::cout << "Simulation completed in " << elapsed.count() << " seconds." << std::endl;
+    return finished;
+}
+
+#endif // ENGINE_H
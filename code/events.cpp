@@ -0,0 +1,182 @@
+/**
+ *          15-418 Final Project
+ *          Title:  Congestion Aware Map Routing
+ *          Credit: Parth Iyer   (pniyer@andrew.cmu.edu)
+ *                  Kwaku Baryeh (kbaryeh@andrew.cmu.edu)
+ */
+
+#include "events.h"
+#include "simulation.h"
+#include "astar.h"
+#include "log.h"
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <algorithm>
+
+bool load_edge_events(const std::string &fname, const Graph &graph, EdgeEvents &events) {
+    std::ifstream file(fname.c_str());
+    if (!file.is_open()) {
+        LOG_ERROR("Unable to open event file " << fname);
+        return false;
+    }
+    events.events.clear();
+    std::string line;
+    int lineNo = 0;
+    int n = graph.vertices.size();
+    while (std::getline(file, line)) {
+        lineNo++;
+        std::stringstream ss(line);
+        std::string first, type;
+        if (!(ss >> first) || first[0] == '#')
+            continue;
+        EdgeEvent e;
+        int u = -1, v = -1;
+        e.capacity = 0;
+        bool ok = (bool) (std::stringstream(first) >> e.tick) && e.tick >= 0 &&
+                  (bool) (ss >> type >> u >> v) && u >= 0 && u < n && v >= 0 && v < n;
+        if (ok && type == "close") {
+            e.type = EDGE_CLOSE;
+        } else if (ok && type == "open") {
+            e.type = EDGE_OPEN;
+        } else if (ok && type == "capacity") {
+            e.type = EDGE_CAPACITY;
+            ok = (bool) (ss >> e.capacity) && e.capacity >= 1;
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            LOG_ERROR(fname << ":" << lineNo << ": expected `tick close|open u v` or `tick capacity u v n`");
+            return false;
+        }
+        e.edge = {u, find_edge(graph, u, v)};
+        if (e.edge.local < 0) {
+            LOG_ERROR(fname << ":" << lineNo << ": there is no edge from " << u << " to " << v);
+            return false;
+        }
+        events.events.push_back(e);
+    }
+    std::stable_sort(events.events.begin(), events.events.end(),
+                     [](const EdgeEvent &a, const EdgeEvent &b) { return a.tick < b.tick; });
+
+    events.next = 0;
+    events.capacity.assign(graph.num_edges, 0);
+    events.closed = 0;
+    for (const EdgeList &list : graph.edges) {
+        for (const Edge &edge : list) {
+            events.capacity[edge.id] = edge.capacity;
+            events.closed += !edge_open(edge);
+        }
+    }
+    events.uses.assign(graph.num_edges, std::vector<RouteUse>());
+    events.indexed.clear();
+    events.entries = events.compact_at = 0;
+    events.applied = events.replanned = events.apply_ns = 0;
+    return true;
+}
+
+// --------------------------------------------------------------------
+// The edge to route index.
+static bool live_use(const VehicleTable &vt, const RouteUse &use) {
+    int i = use.vehicle;
+    return vt.route_version[i] == use.version && !vt.done[i] && vt.cursor[i] <= use.hop;
+}
+
+static void compact_index(EdgeEvents &events, const VehicleTable &vt) {
+    size_t live = 0;
+    for (std::vector<RouteUse> &list : events.uses) {
+        list.erase(std::remove_if(list.begin(), list.end(),
+                                  [&vt](const RouteUse &use) { return !live_use(vt, use); }),
+                   list.end());
+        live += list.size();
+    }
+    // Twice the live entries keeps the compactions amortized over the inserts.
+    events.entries = live;
+    events.compact_at = 2 * live + vt.position.size();
+}
+
+void index_routes(EdgeEvents &events, const Graph &graph, const VehicleTable &vt) {
+    events.indexed.resize(vt.position.size(), -1);
+    for (int i : vt.active) {
+        int version = vt.route_version[i];
+        if (events.indexed[i] == version)
+            continue;
+        events.indexed[i] = version;
+        const std::vector<uint8_t> &hops = vt.route[i];
+        int u = vt.position[i];
+        size_t pos = vt.cursor[i];
+        while (pos < hops.size()) {
+            int hop = pos;
+            const Edge &edge = graph.edges[u][get_hop(hops.data(), pos)];
+            events.uses[edge.id].push_back({i, version, hop});
+            events.entries++;
+            u = edge.start == u ? edge.end : edge.start;
+        }
+    }
+    if (events.entries > events.compact_at)
+        compact_index(events, vt);
+}
+
+// Clears the routes still entering edge `id`. Every entry is stale afterwards.
+static int replan_users(EdgeEvents &events, VehicleTable &vt, int id) {
+    std::vector<RouteUse> &list = events.uses[id];
+    int replanned = 0;
+    for (const RouteUse &use : list) {
+        if (!live_use(vt, use))
+            continue;
+        clear_route(vt, use.vehicle);
+        replanned++;
+    }
+    events.entries -= list.size();
+    list.clear();
+    return replanned;
+}
+
+// --------------------------------------------------------------------
+int apply_edge_events(Graph &graph, VehicleTable &vt, EdgeEvents &events, int tick, bool replan) {
+    if (events.next >= events.events.size() || events.events[events.next].tick > tick)
+        return 0;
+    auto start = std::chrono::steady_clock::now();
+    std::vector<EdgeRef> changed;
+    int replanned = 0;
+    for (; events.next < events.events.size() && events.events[events.next].tick <= tick; events.next++) {
+        const EdgeEvent &e = events.events[events.next];
+        Edge &edge = graph.edges[e.edge.vertex][e.edge.local];
+        bool wasOpen = edge_open(edge);
+        if (e.type == EDGE_CLOSE) {
+            edge.capacity = 0;
+        } else if (e.type == EDGE_OPEN) {
+            edge.capacity = events.capacity[edge.id];
+        } else {
+            events.capacity[edge.id] = e.capacity;
+            if (wasOpen)
+                edge.capacity = e.capacity;
+        }
+        bool isOpen = edge_open(edge);
+        events.closed += (wasOpen && !isOpen) - (!wasOpen && isOpen);
+        changed.push_back(e.edge);
+        events.applied++;
+
+        // Routes never enter a closed edge, so only an open edge which closed
+        // or, when routes are planned on the loads, changed capacity can
+        // invalidate them.
+        int users = 0;
+        if (replan && wasOpen && (!isOpen || edge_cost_mode == COST_LOAD))
+            users = replan_users(events, vt, edge.id);
+        replanned += users;
+        LOG_DEBUG("Tick " << tick << ": edge from " << edge.start << " to " << edge.end
+                  << " now has capacity " << edge.capacity << ", " << users << " vehicles replan");
+    }
+    refresh_route_topology(graph, changed, events.closed);
+    events.replanned += replanned;
+    events.apply_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    return replanned;
+}
+
+void report_edge_events(const EdgeEvents &events) {
+    if (events.applied == 0)
+        return;
+    LOG_INFO("Edge events: " << events.applied << " applied, " << events.replanned
+             << " vehicles replanned, " << events.apply_ns / 1e3 / events.applied << " us per event");
+}
@@ -0,0 +1,134 @@
+/**
+ *          15-418 Final Project
+ *          Title:  Congestion Aware Map Routing
+ *          Credit: Parth Iyer   (pniyer@andrew.cmu.edu)
+ *                  Kwaku Baryeh (kbaryeh@andrew.cmu.edu)
+ */
+
+#ifndef EVENTS_H
+#define EVENTS_H
+
+#include "graph.h"
+#include "vehicles.h"
+#include <string>
+#include <vector>
+#include <cstddef>
+
+/**
+ * Incidents and lane closures during a simulation. An event file has one
+ * event per line, on the directed edge from u to v:
+ *
+ *   tick close u v         No vehicle may enter the edge from this tick on
+ *   tick open u v          The edge is usable again, with its last capacity
+ *   tick capacity u v n    The edge takes n (at least 1) vehicles per tick
+ *
+ * Blank lines and lines starting with # are skipped. A closed edge has
+ * capacity 0 (see edge_open). Only the vehicles whose remaining route enters
+ * a closed edge, or with --edge-cost load an edge whose capacity changed, are
+ * replanned, found through an index from edges to the routes using them.
+ */
+
+enum EdgeEventType {
+    EDGE_CLOSE,
+    EDGE_OPEN,
+    EDGE_CAPACITY
+};
+
+/**
+ * @name                EdgeEvent
+ * @param tick          The tick at whose start the event applies
+ * @param type          What happens to the edge
+ * @param edge          The edge
+ * @param capacity      The new capacity of an EDGE_CAPACITY event
+ */
+struct EdgeEvent {
+    int tick;
+    EdgeEventType type;
+    EdgeRef edge;
+    int capacity;
+};
+
+/**
+ * @name                RouteUse
+ * @details             Vehicle `vehicle` planned to enter an edge with the hop
+ *                      at offset `hop` of its route with version `version`. Entries go stale
+ *                      when the vehicle passes the edge or changes its route,
+ *                      and are dropped when next seen.
+ */
+struct RouteUse {
+    int vehicle;
+    int version;
+    int hop;
+};
+
+/**
+ * @name                EdgeEvents
+ * @details             The events of a simulation and the edge to route index.
+ *
+ * @param events        The events, by tick
+ * @param next          The first event not yet applied
+ * @param capacity      The capacity of each edge when open, by Edge::id
+ * @param closed        The number of edges closed now
+ * @param uses          The routes entering each edge, by Edge::id
+ * @param indexed       The route version of each vehicle in `uses`, or -1
+ * @param entries       The number of entries in `uses`
+ * @param compact_at    Drop the stale entries when there are this many
+ * @param applied       Events applied so far
+ * @param replanned     Vehicles sent to replan by the events
+ * @param apply_ns      Time spent applying events
+ */
+struct EdgeEvents {
+    std::vector<EdgeEvent> events;
+    size_t next;
+    std::vector<int> capacity;
+    int closed;
+    std::vector<std::vector<RouteUse>> uses;
+    std::vector<int> indexed;
+    size_t entries;
+    size_t compact_at;
+    unsigned long applied;
+    unsigned long replanned;
+    unsigned long apply_ns;
+
+    EdgeEvents() : next(0), closed(0), entries(0), compact_at(0), applied(0), replanned(0), apply_ns(0) {}
+};
+
+/**
+ * @name                load_edge_events
+ * @details             Reads an event file for `graph`.
+ *
+ * @return              false (after logging the line) if the file is missing
+ *                      or a line is malformed or names a missing edge
+ */
+bool load_edge_events(const std::string &fname, const Graph &graph, EdgeEvents &events);
+
+/**
+ * @name                index_routes
+ * @details             Adds the routes of the active vehicles which changed
+ *                      since the last call to the index. Costs a comparison
+ *                      per active vehicle plus the length of the new routes.
+ *                      Call after the step phase.
+ */
+void index_routes(EdgeEvents &events, const Graph &graph, const VehicleTable &vt);
+
+/**
+ * @name                apply_edge_events
+ * @details             Applies the events due at or before `tick` to the graph,
+ *                      tells the routers in use which edges changed, and with
+ *                      `replan` clears the routes which enter an affected edge,
+ *                      so step_vehicle plans new ones. Call at the start of a
+ *                      tick, before the step phase. A simulation resuming at
+ *                      tick t calls it with tick t - 1 and without `replan`.
+ *
+ * @return              The number of vehicles sent to replan
+ */
+int apply_edge_events(Graph &graph, VehicleTable &vt, EdgeEvents &events, int tick, bool replan);
+
+/**
+ * @name                report_edge_events
+ * @details             Logs the events applied, the vehicles replanned and
+ *                      the time it took.
+ */
+void report_edge_events(const EdgeEvents &events);
+
+#endif // EVENTS_H
@@ -0,0 +1,329 @@
+/**
+ *          15-418 Final Project
+ *          Title:  Congestion Aware Map Routing
+ *          Credit: Parth Iyer   (pniyer@andrew.cmu.edu)
+ *                  Kwaku Baryeh (kbaryeh@andrew.cmu.edu)
+ */
+
+#include "generator.h"
+#include <vector>
+#include <unordered_set>
+#include <algorithm>
+#include <stdlib.h>
+#include <math.h>
+
+/**
+ * @name     get_rand_Nedges
+ * @details  Get a random number of edges that this vertex should have    
+ */
+static int get_rand_Nedges() {
+    double rand = ((double) random()) / RAND_MAX;
+    if (rand < 0.025) {
+        return 2;
+    } else if (rand < 0.16) {
+        return 3;
+    } else if (rand < 0.5) {
+        return 4;
+    } else if (rand < 0.84) {
+        return 4;
+    } else if (rand < 0.97) {
+        return 5;
+    } else {
+        return 6;
+    }
+}
+
+/**
+ * @name     get_rand_cost
+ * @details  Get the cost to traverse this edge    
+ */
+static int get_rand_coord(int vertices) {
+    int root = (int) sqrt(vertices);
+    return (random() % (2 * root)) + 1;
+}
+
+/**
+ * @name     get_rand_capacity
+ * @details  Get a random capacity for each edge
+ */
+static int get_rand_capacity() {
+    double rand = ((double) random()) / RAND_MAX;
+    if (rand < 0.025) {
+        return 5;
+    } else if (rand < 0.16) {
+        return 4;
+    } else if (rand < 0.5) {
+        return 2;
+    } else if (rand < 0.84) {
+        return 1;
+    } else if (rand < 0.97) {
+        return 3;
+    } else {
+        return 1;
+    }
+}
+
+static bool in(int v, const std::vector<Edge> &e) {
+    for (size_t i = 0; i < e.size(); i++) {
+        if (e[i].start == v || e[i].end == v) {
+            return true;
+        }
+    }
+    return false;
+}
+
+WorkloadOptions::WorkloadOptions()
+    : demand(DEMAND_UNIFORM), hotspots(4), departures(DEPART_NONE), window(100) {}
+
+Problem generate_problem(int n_vertices, int n_cars, const WorkloadOptions &workload) {
+    // Generate Verticies, rejecting duplicate coordinates
+    std::vector<Vertex> vertices;
+    std::unordered_set<long long> taken;
+    for (int i = 0; i < n_vertices; i++) {
+        Vertex v = {i, get_rand_coord(n_vertices), get_rand_coord(n_vertices)};
+        while (!taken.insert(((long long) v.x << 32) | v.y).second) {
+            v.x = get_rand_coord(n_vertices);
+            v.y = get_rand_coord(n_vertices);
+        }
+        vertices.push_back(v);
+    }
+
+    std::vector<std::vector<Edge>> edges(n_vertices);
+
+    std::vector<int> connected;
+
+    // Initalize the number of edges
+    std::vector<int> free_edges(n_vertices);
+    int n_free = 0;
+    for (int i = 0; i < n_vertices; i++) {
+        free_edges[i] = get_rand_Nedges();
+        n_free++;
+    }
+
+    // Initalize Bag
+    std::vector<int> bag(n_vertices);
+    for (int i = 0; i < n_vertices; i++) {
+        bag[i] = i;
+    }
+
+    // Connect the components of the graph
+    while (bag.size() > 0) {
+        int u = random() % bag.size();
+        int w = bag[u];
+        bag[u] = bag.back();
+        bag.pop_back();
+        if (connected.size() == 0) {
+            connected.push_back(w);
+        } else {
+            int v = connected[random() % connected.size()];
+            while (free_edges[v] <= 0) {
+                v = connected[random() % connected.size()];
+            }
+
+            int capacity = get_rand_capacity();
+
+            edges[w].push_back({w, v, capacity, 0, std::map<int, int>()});
+            edges[v].push_back({v, w, capacity, 0, std::map<int, int>()});
+
+            n_free -= (--free_edges[v] == 0);
+            n_free -= (--free_edges[w] == 0);
+
+            connected.push_back(w);
+        }
+    }
+
+    // Use up the remaining free edges. Vertices which can not find a partner
+    // within a bounded number of tries keep their spare degree.
+    for (int u = 0; u < (int) free_edges.size(); u++ ) {
+        while (free_edges[u] > 0 && n_free > 1) {
+            int tries = 0;
+            int v = connected[random() % connected.size()];
+            while ((free_edges[v] <= 0 || v == u || in(v, edges[u])) && ++tries < 8 * n_vertices) {
+                v = connected[random() % connected.size()];
+            }
+            if (free_edges[v] <= 0 || v == u || in(v, edges[u]))
+                break;
+
+            int capacity = get_rand_capacity();
+
+            edges[u].push_back({u, v, capacity, 0, std::map<int, int>()});
+            edges[v].push_back({v, u, capacity, 0, std::map<int, int>()});
+
+            n_free -= (--free_edges[v] == 0);
+            n_free -= (--free_edges[u] == 0);
+        }
+    }
+
+    // Generate the graph
+    Problem p = {make_graph(vertices, edges), std::vector<Car>()};
+    generate_cars(p, n_cars, workload);
+    return p;
+}
+
+Problem generate_problem(int n_vertices, int n_cars) {
+    return generate_problem(n_vertices, n_cars, WorkloadOptions());
+}
+
+// --------------------------------------------------------------------
+// Demand models.
+
+static double rand_unit() {
+    return ((double) random()) / ((double) RAND_MAX + 1.0);
+}
+
+// Standard normal sample (Box-Muller).
+static double rand_normal() {
+    double u = rand_unit();
+    double v = rand_unit();
+    return sqrt(-2.0 * log(1.0 - u)) * cos(2.0 * M_PI * v);
+}
+
+/**
+ * @name     Hotspot
+ * @details  A centre of attraction: the vertices nearest to a random centre
+ *           vertex, closest first, and the hotspot's relative popularity.
+ */
+struct Hotspot {
+    int center;
+    std::vector<int> members;
+    double weight;
+};
+
+static std::vector<Hotspot> make_hotspots(const Graph &g, int count) {
+    int n = g.vertices.size();
+    int size = std::max(1, std::min(n, n / (4 * count)));
+    std::vector<Hotspot> hotspots(count);
+    std::vector<std::pair<long long, int>> byDistance(n);
+    for (int k = 0; k < count; k++) {
+        Hotspot &h = hotspots[k];
+        h.center = random() % n;
+        // Zipf-like popularity: a few hotspots draw most of the traffic.
+        h.weight = 1.0 / (k + 1);
+        const Vertex &c = g.vertices[h.center];
+        for (int v = 0; v < n; v++) {
+            long long dx = g.vertices[v].x - c.x;
+            long long dy = g.vertices[v].y - c.y;
+            byDistance[v] = std::make_pair(dx * dx + dy * dy, v);
+        }
+        std::nth_element(byDistance.begin(), byDistance.begin() + (size - 1), byDistance.end());
+        std::sort(byDistance.begin(), byDistance.begin() + size);
+        for (int m = 0; m < size; m++)
+            h.members.push_back(byDistance[m].second);
+    }
+    return hotspots;
+}
+
+// A vertex of the hotspot, concentrated towards its centre.
+static int pick_in_hotspot(const Hotspot &h) {
+    double u = rand_unit();
+    return h.members[(size_t) (u * u * h.members.size())];
+}
+
+static int pick_weighted(const std::vector<double> &weights) {
+    double total = 0;
+    for (double w : weights)
+        total += w;
+    double r = rand_unit() * total;
+    for (size_t k = 0; k < weights.size(); k++) {
+        r -= weights[k];
+        if (r < 0)
+            return k;
+    }
+    return weights.size() - 1;
+}
+
+// Gravity model: a hotspot attracts trips in proportion to its popularity
+// and inversely to the square of its distance from the origin.
+static int pick_gravity(const Graph &g, const std::vector<Hotspot> &hotspots, int origin) {
+    std::vector<double> weights(hotspots.size());
+    const Vertex &o = g.vertices[origin];
+    for (size_t k = 0; k < hotspots.size(); k++) {
+        const Vertex &c = g.vertices[hotspots[k].center];
+        double d = abs(c.x - o.x) + abs(c.y - o.y);
+        weights[k] = hotspots[k].weight / ((1.0 + d) * (1.0 + d));
+    }
+    return pick_weighted(weights);
+}
+
+static int pick_departure(const WorkloadOptions &w) {
+    switch (w.departures) {
+    case DEPART_UNIFORM:
+        return random() % w.window;
+    case DEPART_RUSH: {
+        // Two peaks, morning and evening, a quarter of the window from each end.
+        double peak = rand_unit() < 0.5 ? 0.25 : 0.75;
+        int t = (int) ((peak + 0.08 * rand_normal()) * w.window);
+        return std::max(0, std::min(w.window - 1, t));
+    }
+    default:
+        return 0;
+    }
+}
+
+void generate_cars(Problem &p, int n_cars, const WorkloadOptions &w) {
+    const Graph &g = p.graph;
+    int n_vertices = g.vertices.size();
+    std::vector<Car> &c = p.cars;
+    c.clear();
+    c.reserve(n_cars);
+
+    std::vector<Hotspot> homes, hotspots;
+    std::vector<double> homeWeights, workWeights;
+    if (w.demand == DEMAND_HOTSPOT) {
+        hotspots = make_hotspots(g, w.hotspots);
+    } else if (w.demand == DEMAND_COMMUTER) {
+        // Residential clusters are many and even, business clusters few and
+        // dominated by the first.
+        homes = make_hotspots(g, 2 * w.hotspots);
+        hotspots = make_hotspots(g, w.hotspots);
+        homeWeights.assign(homes.size(), 1.0);
+        for (const Hotspot &h : hotspots)
+            workWeights.push_back(h.weight);
+    }
+
+    for (int i = 0; i < n_cars; i++) {
+        int depart = pick_departure(w);
+        int src, dest;
+        if (w.demand == DEMAND_HOTSPOT) {
+            src = random() % n_vertices;
+            dest = pick_in_hotspot(hotspots[pick_gravity(g, hotspots, src)]);
+        } else if (w.demand == DEMAND_COMMUTER) {
+            src = pick_in_hotspot(homes[pick_weighted(homeWeights)]);
+            dest = pick_in_hotspot(hotspots[pick_weighted(workWeights)]);
+            // In the second half of the day commuters head home.
+            if (w.departures != DEPART_NONE && depart >= w.window / 2)
+                std::swap(src, dest);
+        } else {
+            src = random() % n_vertices;
+            dest = random() % n_vertices;
+        }
+        while (dest == src) {
+            dest = random() % n_vertices;
+        }
+        c.push_back({src, dest, depart});
+    }
+}
+
+bool parse_demand_model(const std::string &name, DemandModel &model) {
+    if (name == "uniform")
+        model = DEMAND_UNIFORM;
+    else if (name == "hotspot")
+        model = DEMAND_HOTSPOT;
+    else if (name == "commuter")
+        model = DEMAND_COMMUTER;
+    else
+        return false;
+    return true;
+}
+
+bool parse_departure_model(const std::string &name, DepartureModel &model) {
+    if (name == "none")
+        model = DEPART_NONE;
+    else if (name == "uniform")
+        model = DEPART_UNIFORM;
+    else if (name == "rush")
+        model = DEPART_RUSH;
+    else
+        return false;
+    return true;
+}
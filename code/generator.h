@@ -0,0 +1,109 @@
+/**
+ *          15-418 Final Project
+ *          Title:  Congestion Aware Map Routing
+ *          Credit: Parth Iyer   (pniyer@andrew.cmu.edu)
+ *                  Kwaku Baryeh (kbaryeh@andrew.cmu.edu)
+ */
+
+#ifndef GENERATOR_H
+#define GENERATOR_H
+
+#include "graph.h"
+#include <string>
+
+/**
+ * @name                DemandModel
+ * @details             How car origins and destinations are chosen.
+ *
+ * DEMAND_UNIFORM       Sources and destinations uniformly at random
+ * DEMAND_HOTSPOT       Uniform sources; destinations drawn to hotspots by a
+ *                      gravity model (popularity over squared distance)
+ * DEMAND_COMMUTER      Trips between residential and business clusters
+ */
+enum DemandModel {
+    DEMAND_UNIFORM,
+    DEMAND_HOTSPOT,
+    DEMAND_COMMUTER
+};
+
+/**
+ * @name                DepartureModel
+ * @details             When cars enter the road network.
+ *
+ * DEPART_NONE          Every car departs at tick 0
+ * DEPART_UNIFORM       Uniformly over [0, window)
+ * DEPART_RUSH          Morning and evening peaks within [0, window); commuters
+ *                      travel home in the evening
+ */
+enum DepartureModel {
+    DEPART_NONE,
+    DEPART_UNIFORM,
+    DEPART_RUSH
+};
+
+/**
+ * @name                WorkloadOptions
+ * @details             The traffic scenario to generate.
+ *
+ * @param demand        The origin/destination model
+ * @param hotspots      Number of hotspots (business clusters for commuters,
+ *                      which get twice as many residential clusters)
+ * @param departures    The departure time distribution
+ * @param window        Ticks over which departures are spread
+ */
+struct WorkloadOptions {
+    DemandModel demand;
+    int hotspots;
+    DepartureModel departures;
+    int window;
+
+    WorkloadOptions();
+};
+
+/**
+ * @name                generate_problem
+ * @details             Generates a connected random graph with `vertices`
+ *                      vertices on a 2*sqrt(V) by 2*sqrt(V) grid and `cars`
+ *                      cars with random sources and destinations. Uses
+ *                      random(), so seed it with srandom() for other instances.
+ *                      Runs in roughly O(V log V) so million-vertex graphs are
+ *                      practical.
+ *
+ * @param[in] vertices  The number of vertices
+ * @param[in] cars      The number of cars
+ * @return              The generated problem (without an adjacency matrix)
+ */
+Problem generate_problem(int vertices, int cars);
+
+/**
+ * @name                generate_problem
+ * @details             As above, with the cars drawn from a workload scenario.
+ *                      The default WorkloadOptions give the same problem as
+ *                      the two argument version for the same seed.
+ */
+Problem generate_problem(int vertices, int cars, const WorkloadOptions &workload);
+
+/**
+ * @name                generate_cars
+ * @details             Replaces the cars of a problem with `cars` new ones
+ *                      drawn from the workload scenario.
+ */
+void generate_cars(Problem &p, int cars, const WorkloadOptions &workload);
+
+/**
+ * @name                parse_demand_model
+ * @details             Parses uniform, hotspot or commuter.
+ *
+ * @return              false if the name is unknown
+ */
+bool parse_demand_model(const std::string &name, DemandModel &model);
+
+/**
+ * @name                parse_departure_model
+ * @details             Parses none, uniform or rush.
+ *
+ * @return              false if the name is unknown
+ */
+bool parse_departure_model(const std::string &name, DepartureModel &model);
+
+#endif // GENERATOR_H
@@ -91,51 +91,70 @@ Problem load_problem(std::string& fname) {
         std::stringstream ss(cars);
         std::string line;
         while (std::getline(ss, line, '\n')) {
-            line = line.substr(1, line.find(")"));
-            int src = std::stoi(line.substr(0, line.find(",")));
-            int dest = std::stoi(line.substr(line.find(",")+1));
-            c.push_back({src, dest});
+            // "(src,dest)" or "(src,dest,depart)"
+            int src = 0, dest = 0, depart = 0;
+            if (sscanf(line.c_str(), "(%d,%d,%d)", &src, &dest, &depart) < 2)
+                continue;
+            c.push_back({src, dest, depart});
         }
     }
 
-    Graph g = {v, e, calculate_adj_matrix(e)};
+    return {make_graph(v, e), c};
+}
+
+Graph make_graph(const std::vector<Vertex> &vertices, const std::vector<std::vector<Edge>> &edges) {
+    Graph g;
+    g.vertices.assign(vertices.begin(), vertices.end());
+    g.edges.reserve(edges.size());
+    for (const std::vector<Edge> &list : edges)
+        g.edges.emplace_back(list.begin(), list.end());
+    number_edges(g);
+    return g;
+}
 
-    return {g, c};
+void number_edges(Graph &g) {
+    g.num_edges = 0;
+    for (auto &list : g.edges)
+        for (Edge &edge : list)
+            edge.id = g.num_edges++;
 }
 
-void save_problem(const Problem &p) {
+void save_problem(const Problem &p, FILE *out) {
     // Print Vertices
     for (int i = 0; i < p.graph.vertices.size(); i++) {
-        printf("%d:(%d,%d)\n", p.graph.vertices[i].id, p.graph.vertices[i].x, p.graph.vertices[i].y);
+        fprintf(out, "%d:(%d,%d)\n", p.graph.vertices[i].id, p.graph.vertices[i].x, p.graph.vertices[i].y);
     }
 
-    printf("EDGES\n");
+    fprintf(out, "EDGES\n");
 
     // Print Edges
     for (int i = 0; i < p.graph.edges.size(); i++) {
-        printf("%d:", i);
+        fprintf(out, "%d:", i);
         for (int j = 0; j < p.graph.edges[i].size(); j++) {
-            printf("(%d,%d,%d)", p.graph.edges[i][j].start, p.graph.edges[i][j].end, p.graph.edges[i][j].capacity);
+            fprintf(out, "(%d,%d,%d)", p.graph.edges[i][j].start, p.graph.edges[i][j].end, p.graph.edges[i][j].capacity);
         }
-        printf("\n");
+        fprintf(out, "\n");
     }
 
-    printf("CARS\n");
+    fprintf(out, "CARS\n");
 
     // Print all the Cars
     for (int i = 0; i < p.cars.size(); i++) {
-        printf("(%d,%d)\n", p.cars[i].src, p.cars[i].dest);
+        if (p.cars[i].depart > 0)
+            fprintf(out, "(%d,%d,%d)\n", p.cars[i].src, p.cars[i].dest, p.cars[i].depart);
+        else
+            fprintf(out, "(%d,%d)\n", p.cars[i].src, p.cars[i].dest);
     }
 }
 
-std::vector<std::vector<int>> calculate_adj_matrix(std::vector<std::vector<Edge>> edges) {
+std::vector<std::vector<int>> calculate_adj_matrix(const std::vector<EdgeList, ArenaAllocator<EdgeList>> &edges) {
     std::vector<std::vector<int>> adj(edges.size());
     for (int i = 0; i < edges.size(); i++) {
         adj[i] = std::vector<int>(edges.size());
     }
 
     for (int i = 0; i < edges.size(); i++)
-        for (Edge e : edges[i])
+        for (const Edge &e : edges[i])
             adj[e.start][e.end] = 1;
     
     return adj;
@@ -151,7 +170,7 @@ void print_graph(const Graph &g) {
     fprintf(stderr, "Edges:\n");
     for (int i = 0; i < g.edges.size(); i++) {
         for (int j = 0; j < g.edges[i].size(); j++) {
-            fprintf(stderr, "(\nstart: %d\nend: %d\ncapacity: %d\nload: %d\n", g.edges[i][j].start, g.edges[i][j].end, g.edges[i][j].capacity, g.edges[i][j].load);
+            fprintf(stderr, "(\nstart: %d\nend: %d\ncapacity: %d\nid: %d\n", g.edges[i][j].start, g.edges[i][j].end, g.edges[i][j].capacity, g.edges[i][j].id);
             fprintf(stderr, "map:\n");
             for (const auto& pair : g.edges[i][j].costs) {
                 fprintf(stderr, "\t%d: %d\n", pair.first, pair.second);
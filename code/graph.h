@@ -8,9 +8,11 @@
 #ifndef GRAPH
 #define GRAPH
 
+#include "arena.h"
 #include <vector>
 #include <map>
 #include <string>
+#include <stdio.h>
 
 /**
  * @name                Vertex
@@ -35,12 +37,14 @@ struct Vertex {
  * @param start         The starting vertex of the edge
  * @param end           The ending vertex of the edge
  * @param base_cost     The minimum time (in min) it takes to traverse this edge
+ * @param id            The index of the edge in per-edge arrays, such as the
+ *                      loads of a simulation (see number_edges)
  * @param costs         A map from a time slice (integer) to the realtime cost
  */
 struct Edge {
     int start, end;
     int capacity;
-    int load;
+    int id;
     std::map<int, int> costs;
 };
 
@@ -50,12 +54,21 @@ struct Edge {
  * 
  * @param src           The starting vertex of the car
  * @param dest          The ending vertex of the car
+ * @param depart        The tick at which the car enters the network
  */
 struct Car {
     int src;
     int dest;
+    int depart;
 };
 
+/**
+ * The vertex and edge lists live in the graph arena (see arena.h), on huge
+ * pages where the kernel has them.
+ */
+typedef std::vector<Vertex, ArenaAllocator<Vertex>> VertexList;
+typedef std::vector<Edge, ArenaAllocator<Edge>> EdgeList;
+
 /**
  * @name                Graph
  * @details             Enumerates Verticies, Edges, and adjacency matrix
@@ -63,11 +76,17 @@ struct Car {
  * @param vertices      A list of all the vertices in the graph
  * @param edges         A list of all the edges in the graph
  * @param adj           An adjacency matrix format for all the edges
+ * @param num_edges     The number of edges, counting both directions
+ *
+ * The graph only holds the topology, which stays fixed during a simulation;
+ * the loads live with the vehicles (see VehicleTable), so several simulations
+ * can share one graph.
  */
 struct Graph {
-    std::vector<Vertex> vertices;
-    std::vector<std::vector<Edge>> edges;
+    VertexList vertices;
+    std::vector<EdgeList, ArenaAllocator<EdgeList>> edges;
     std::vector<std::vector<int>> adj;
+    int num_edges;
 };
 
 /**
@@ -83,6 +102,31 @@ struct Problem {
     std::vector<Car> cars;
 };
 
+/**
+ * @name                edge_open
+ * @details             A closed edge (see events.h) has no capacity, and no
+ *                      route may use it.
+ */
+inline bool edge_open(const Edge &edge) {
+    return edge.capacity > 0;
+}
+
+/**
+ * @name                make_graph
+ * @details             Copies vertices and edge lists built with the standard
+ *                      allocator into graph storage, each list exactly sized
+ *                      and in vertex order, and numbers the edges.
+ */
+Graph make_graph(const std::vector<Vertex> &vertices, const std::vector<std::vector<Edge>> &edges);
+
+/**
+ * @name                number_edges
+ * @details             Gives every edge its id, in edge list order, and sets
+ *                      num_edges. load_problem and the generator call it;
+ *                      call it again after changing the edge lists.
+ */
+void number_edges(Graph &g);
+
 /**
  * @name                load_problem
  * @details             loads the problem 
@@ -91,7 +135,8 @@ struct Problem {
  *                      and Cars)
  * 
  * @return              Problem structure packed with the problem data loaded 
- *                      from the file   
+ *                      from the file. The dense adjacency matrix is not built
+ *                      (it is V^2 ints); call calculate_adj_matrix if needed.
  */
 Problem load_problem(std::string &fname);
 
@@ -101,17 +146,18 @@ Problem load_problem(std::string &fname);
  *                      stdout
  * 
  * @param[in] p         A problem instance which we will print
+ * @param[in] out       Where to print it, stdout by default
  */
-void save_problem(const Problem &p);
+void save_problem(const Problem &p, FILE *out = stdout);
 
 /**
  * @name                calculate_adj_matrix
  * @details             calulates adjacency matrix based on Edges
  * 
- * @param[in] edges     a vector of vector of edges
+ * @param[in] edges     the edge lists of a graph
  * @returns             an adjacency matrix with a 1 where an edge exists and 0 otherwise
  */
-std::vector<std::vector<int>> calculate_adj_matrix(std::vector<std::vector<Edge>> edges);
+std::vector<std::vector<int>> calculate_adj_matrix(const std::vector<EdgeList, ArenaAllocator<EdgeList>> &edges);
 
 /**
  * @name                print_graph
@@ -0,0 +1,218 @@
+/**
+ *          15-418 Final Project
+ *          Title:  Congestion Aware Map Routing
+ *          Credit: Parth Iyer   (pniyer@andrew.cmu.edu)
+ *                  Kwaku Baryeh (kbaryeh@andrew.cmu.edu)
+ */
+
+#include "gridlock.h"
+#include "log.h"
+#include <sstream>
+#include <algorithm>
+
+// The most vehicles of a gridlock spelled out in its log message.
+static const int GRIDLOCK_LOG_ARCS = 8;
+
+bool parse_gridlock_policy(const std::string &name, GridlockPolicy &policy) {
+    if (name == "off")
+        policy = GRIDLOCK_OFF;
+    else if (name == "report")
+        policy = GRIDLOCK_REPORT;
+    else if (name == "replan")
+        policy = GRIDLOCK_REPLAN;
+    else if (name == "abort")
+        policy = GRIDLOCK_ABORT;
+    else
+        return false;
+    return true;
+}
+
+void init_gridlock_detector(GridlockDetector &det, const Graph &graph, const VehicleTable &vt,
+                            int workers, GridlockPolicy policy, int after) {
+    det.policy = policy;
+    det.after = after;
+    det.node.assign(vt.position.size(), -1);
+    det.waiter.assign(graph.num_edges, -1);
+    det.entries.assign(workers, std::vector<std::pair<int, int>>());
+    det.arcs.assign(workers, std::vector<std::pair<int, int>>());
+    det.found = det.caught = det.replanned = 0;
+}
+
+int collect_blocked(GridlockDetector &det, const Graph &graph, const VehicleTable &vt,
+                    std::vector<VehicleShard> &shards) {
+    det.blocked.clear();
+    for (VehicleShard &shard : shards) {
+        det.blocked.insert(det.blocked.end(), shard.blocked.begin(), shard.blocked.end());
+        shard.blocked.clear();
+    }
+    std::sort(det.blocked.begin(), det.blocked.end());
+
+    int n = det.blocked.size();
+    bool stuck = false;
+    for (int i : det.blocked)
+        stuck = stuck || vt.waited[i] >= det.after;
+    if (!stuck) {
+        det.blocked.clear();
+        return 0;
+    }
+    det.waits.resize(n);
+    det.target.resize(n);
+    det.nextWaiter.resize(n);
+    for (int k = 0; k < n; k++) {
+        int i = det.blocked[k];
+        int u = vt.position[i];
+        int local = next_edge(vt, i);
+        const Edge &edge = graph.edges[u][local];
+        det.node[i] = k;
+        det.waits[k] = edge.id;
+        det.target[k] = hop_target(graph, u, local);
+        det.nextWaiter[k] = det.waiter[edge.id];
+        det.waiter[edge.id] = k;
+    }
+    return n;
+}
+
+void link_blocked(GridlockDetector &det, int w) {
+    std::vector<std::pair<int, int>> &arcs = det.arcs[w];
+    arcs.clear();
+    for (const std::pair<int, int> &e : det.entries[w]) {
+        int to = det.node[e.second];
+        if (to < 0)
+            continue;
+        for (int from = det.waiter[e.first]; from >= 0; from = det.nextWaiter[from])
+            arcs.push_back(std::make_pair(from, to));
+    }
+}
+
+// Logs the gridlock made of the slots comp and adds the vehicle to leave it
+// to det.members. One vehicle out of the ring breaks it; routing them all out
+// would just form the ring again the other way round.
+static void record_gridlock(GridlockDetector &det, VehicleTable &vt, std::vector<int> &comp, int tick) {
+    std::sort(comp.begin(), comp.end());
+    det.members.push_back(det.blocked[comp[0]]);
+    std::ostringstream arcs;
+    for (size_t c = 0; c < comp.size(); c++) {
+        int k = comp[c];
+        int i = det.blocked[k];
+        vt.waited[i] = 0;
+        TRACE_EVENT(tick, i, TRACE_GRIDLOCK, vt.position[i], det.target[k]);
+        if (c < (size_t) GRIDLOCK_LOG_ARCS)
+            arcs << " " << i << "@" << vt.position[i] << "->" << det.target[k];
+    }
+    det.found++;
+    det.caught += comp.size();
+    LOG_WARN("Tick " << tick << ": gridlock of " << (unsigned long) comp.size()
+             << " vehicles (vehicle@vertex->next):" << arcs.str()
+             << (comp.size() > (size_t) GRIDLOCK_LOG_ARCS ? " ..." : ""));
+}
+
+int find_gridlocks(GridlockDetector &det, VehicleTable &vt, int tick) {
+    int nodes = det.blocked.size();
+    det.members.clear();
+
+    // The workers' arcs as adjacency lists, in an order which does not depend
+    // on how the entries were split between them.
+    std::vector<std::pair<int, int>> all;
+    for (const std::vector<std::pair<int, int>> &arcs : det.arcs)
+        all.insert(all.end(), arcs.begin(), arcs.end());
+    std::sort(all.begin(), all.end());
+    det.start.assign(nodes + 1, 0);
+    det.head.resize(all.size());
+    for (size_t a = 0; a < all.size(); a++) {
+        det.start[all[a].first + 1]++;
+        det.head[a] = all[a].second;
+    }
+    for (int k = 0; k < nodes; k++)
+        det.start[k + 1] += det.start[k];
+
+    det.index.assign(nodes, -1);
+    det.low.assign(nodes, 0);
+    det.onStack.assign(nodes, 0);
+    std::vector<int> comp;
+    int counter = 0, gridlocks = 0;
+
+    // Tarjan's algorithm with an explicit stack of (slot, next arc) frames.
+    for (int root = 0; root < nodes && !all.empty(); root++) {
+        if (det.index[root] >= 0)
+            continue;
+        det.frames.assign({root, det.start[root]});
+        det.index[root] = det.low[root] = counter++;
+        det.stack.push_back(root);
+        det.onStack[root] = 1;
+        while (!det.frames.empty()) {
+            int n = det.frames[det.frames.size() - 2];
+            int a = det.frames.back();
+            if (a < det.start[n + 1]) {
+                det.frames.back()++;
+                int m = det.head[a];
+                if (det.index[m] < 0) {
+                    det.index[m] = det.low[m] = counter++;
+                    det.stack.push_back(m);
+                    det.onStack[m] = 1;
+                    det.frames.push_back(m);
+                    det.frames.push_back(det.start[m]);
+                } else if (det.onStack[m]) {
+                    det.low[n] = std::min(det.low[n], det.index[m]);
+                }
+                continue;
+            }
+            det.frames.resize(det.frames.size() - 2);
+            if (!det.frames.empty()) {
+                int parent = det.frames[det.frames.size() - 2];
+                det.low[parent] = std::min(det.low[parent], det.low[n]);
+            }
+            if (det.low[n] != det.index[n])
+                continue;
+            comp.clear();
+            int m;
+            do {
+                m = det.stack.back();
+                det.stack.pop_back();
+                det.onStack[m] = 0;
+                comp.push_back(m);
+            } while (m != n);
+            // A vehicle never waits for an edge it entered itself, so a
+            // single slot is not a ring.
+            bool stuck = false;
+            for (int k : comp)
+                stuck = stuck || vt.waited[det.blocked[k]] >= det.after;
+            if (comp.size() > 1 && stuck) {
+                record_gridlock(det, vt, comp, tick);
+                gridlocks++;
+            }
+        }
+    }
+
+    for (int k = 0; k < nodes; k++) {
+        det.node[det.blocked[k]] = -1;
+        det.waiter[det.waits[k]] = -1;
+    }
+    det.resolved.assign(det.members.size(), 0);
+    return gridlocks;
+}
+
+void track_entries(GridlockDetector &det, const Graph &graph, std::vector<VehicleShard> &shards, int w) {
+    VehicleShard &shard = shards[w];
+    std::vector<std::pair<int, int>> &entries = det.entries[w];
+    entries.resize(shard.movers.size());
+    for (size_t k = 0; k < shard.movers.size(); k++) {
+        const EdgeRef &e = shard.moved[k];
+        entries[k] = std::make_pair(graph.edges[e.vertex][e.local].id, shard.movers[k]);
+    }
+    shard.movers.clear();
+}
+
+unsigned long count_replanned(GridlockDetector &det) {
+    unsigned long replanned = 0;
+    for (char r : det.resolved)
+        replanned += r;
+    det.replanned += replanned;
+    return replanned;
+}
+
+void report_gridlocks(const GridlockDetector &det) {
+    if (det.found == 0)
+        return;
+    LOG_INFO("Gridlocks: " << det.found << " found, " << det.caught << " vehicles caught, "
+             << det.replanned << " replanned around them");
+}
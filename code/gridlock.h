@@ -0,0 +1,164 @@
+/**
+ *          15-418 Final Project
+ *          Title:  Congestion Aware Map Routing
+ *          Credit: Parth Iyer   (pniyer@andrew.cmu.edu)
+ *                  Kwaku Baryeh (kbaryeh@andrew.cmu.edu)
+ */
+
+#ifndef GRIDLOCK_H
+#define GRIDLOCK_H
+
+#include "graph.h"
+#include "vehicles.h"
+#include <string>
+#include <vector>
+#include <utility>
+
+/**
+ * Gridlock detection. An edge is full when the vehicles which entered it last
+ * tick used up its capacity, so the wait-for graph of a tick has an arc from
+ * each vehicle waiting for a full edge to those among the vehicles which
+ * entered it that wait too. A strongly connected component of it is a ring
+ * of vehicles each held up by the next. The vehicles which filled an edge
+ * moved last tick, and a full edge is empty the tick after, so the vehicles
+ * of a ring crawl along, waiting every other tick; the ring is a gridlock
+ * once one of them has waited `after` ticks that way (see VehicleTable::
+ * waited). Every tick each worker only keeps the entries its vehicles made,
+ * and the graph is only built on ticks with a vehicle waiting that long.
+ */
+
+enum GridlockPolicy {
+    GRIDLOCK_OFF,       // Do not look for gridlocks
+    GRIDLOCK_REPORT,    // Log them and keep going
+    GRIDLOCK_REPLAN,    // Route a vehicle of each around the edge it waits for
+    GRIDLOCK_ABORT      // Stop the simulation
+};
+
+/**
+ * @name                parse_gridlock_policy
+ * @details             Maps off, report, replan or abort to the policy.
+ *
+ * @return              false if the name is unknown
+ */
+bool parse_gridlock_policy(const std::string &name, GridlockPolicy &policy);
+
+/**
+ * @name                GridlockDetector
+ * @details             The wait-for graph of one tick and the gridlocks found
+ *                      so far. The vehicles waiting this tick are its nodes.
+ *
+ * @param policy        What to do about a gridlock
+ * @param after         The ticks a vehicle of a gridlock has waited at least
+ * @param blocked       The vehicles waiting this tick, by id
+ * @param waits         The edge id each of `blocked` waits to enter
+ * @param target        The vertex each of `blocked` waits to enter
+ * @param node          The slot in `blocked` of each vehicle, or -1
+ * @param waiter        The first slot waiting for each edge id, or -1
+ * @param nextWaiter    The next slot waiting for the same edge, or -1
+ * @param entries       Each worker's (edge id, vehicle) entries of last tick
+ * @param arcs          Each worker's (from, to) slots found by link_blocked
+ * @param start         The first arc of each slot in `head`, and the end
+ * @param head          The slot each arc leads to
+ * @param members       The vehicle with the lowest id of each gridlock of this
+ *                      tick, the one routed out of it
+ * @param resolved      Whether each of `members` got a route around its gridlock
+ * @param found         Gridlocks found so far
+ * @param caught        Vehicles caught in them
+ * @param replanned     Vehicles routed around them
+ */
+struct GridlockDetector {
+    GridlockPolicy policy;
+    int after;
+    std::vector<int> blocked;
+    std::vector<int> waits;
+    std::vector<int> target;
+    std::vector<int> node;
+    std::vector<int> waiter;
+    std::vector<int> nextWaiter;
+    std::vector<std::vector<std::pair<int, int>>> entries;
+    std::vector<std::vector<std::pair<int, int>>> arcs;
+    std::vector<int> start;
+    std::vector<int> head;
+    std::vector<int> members;
+    std::vector<char> resolved;
+    unsigned long found;
+    unsigned long caught;
+    unsigned long replanned;
+
+    // Tarjan's scratch space, by slot.
+    std::vector<int> index, low, stack, frames;
+    std::vector<char> onStack;
+
+    GridlockDetector() : policy(GRIDLOCK_OFF), after(0), found(0), caught(0), replanned(0) {}
+};
+
+/**
+ * @name                init_gridlock_detector
+ * @param workers       The number of shards the simulation steps with
+ * @param after         The ticks a vehicle of a gridlock has waited at least
+ */
+void init_gridlock_detector(GridlockDetector &det, const Graph &graph, const VehicleTable &vt,
+                            int workers, GridlockPolicy policy, int after);
+
+/**
+ * @name                collect_blocked
+ * @details             Moves the shards' blocked lists into `det`, in an
+ *                      order which does not depend on the threads, and notes
+ *                      the edge each waits for.
+ *
+ * @return              The number of waiting vehicles, or 0 if none has
+ *                      waited `after` ticks and no ring can be a gridlock
+ */
+int collect_blocked(GridlockDetector &det, const Graph &graph, const VehicleTable &vt,
+                    std::vector<VehicleShard> &shards);
+
+/**
+ * @name                link_blocked
+ * @details             Finds the arcs out of the entries worker w made last
+ *                      tick: one from every vehicle waiting for the edge to
+ *                      the vehicle which entered it, if that waits too,
+ *                      whatever their wait counts. Any thread may
+ *                      link any w once collect_blocked returned.
+ */
+void link_blocked(GridlockDetector &det, int w);
+
+/**
+ * @name                find_gridlocks
+ * @details             Finds the strongly connected components of the
+ *                      wait-for graph, logs each holding a vehicle which has
+ *                      waited `after` ticks as a gridlock and puts one of its
+ *                      vehicles in det.members. Their wait counts start over,
+ *                      so a gridlock which persists is reported again after
+ *                      `after` ticks rather than on every tick.
+ *
+ * @return              The number of gridlocks
+ */
+int find_gridlocks(GridlockDetector &det, VehicleTable &vt, int tick);
+
+/**
+ * @name                track_entries
+ * @details             Keeps the edges the vehicles of shard w entered this
+ *                      tick for the next tick's arcs, and empties its movers.
+ *                      Call on every tick, after find_gridlocks and before
+ *                      the shard's moves are merged into the loads.
+ */
+void track_entries(GridlockDetector &det, const Graph &graph, std::vector<VehicleShard> &shards, int w);
+
+/**
+ * @name                count_replanned
+ * @details             Counts the members which got a new route, after the
+ *                      caller stored the results of replan_around in
+ *                      det.resolved. The others wait on; a ring of them is
+ *                      found again once they have waited `after` more ticks.
+ *
+ * @return              The number which got one
+ */
+unsigned long count_replanned(GridlockDetector &det);
+
+/**
+ * @name                report_gridlocks
+ * @details             Logs the gridlocks found and the vehicles replanned.
+ */
+void report_gridlocks(const GridlockDetector &det);
+
+#endif // GRIDLOCK_H
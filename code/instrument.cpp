@@ -0,0 +1,209 @@
+/**
+ *          15-418 Final Project
+ *          Title:  Congestion Aware Map Routing
+ *          Credit: Parth Iyer   (pniyer@andrew.cmu.edu)
+ *                  Kwaku Baryeh (kbaryeh@andrew.cmu.edu)
+ */
+
+#include "instrument.h"
+#include "log.h"
+#include <vector>
+#include <mutex>
+#include <cstring>
+#include <cstdlib>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+bool g_instrument_enabled = false;
+thread_local ThreadCounters *t_counters = NULL;
+uint64_t instrument_phase_ns[PHASE_COUNT];
+const int *instrument_vertex_node = NULL;
+thread_local int t_instrument_node = 0;
+
+/**
+ * @name                TickSample
+ * @details             One row of the per-tick time series.
+ */
+struct TickSample {
+    int tick;
+    int active;
+    uint64_t phase_ns[PHASE_COUNT];
+    ThreadCounters total;
+    int threads;
+    double utilization;
+    long long cache_misses;
+    long long branch_misses;
+};
+
+static std::mutex registry_lock;
+static std::vector<ThreadCounters *> registry;
+static std::vector<TickSample> samples;
+static std::string profile_file;
+static bool hw_counters = false;
+
+// --------------------------------------------------------------------
+// Hardware counters.
+int perf_counter_open(uint64_t config, bool inherit) {
+    struct perf_event_attr pe;
+    memset(&pe, 0, sizeof(pe));
+    pe.type = PERF_TYPE_HARDWARE;
+    pe.size = sizeof(pe);
+    pe.config = config;
+    pe.inherit = inherit ? 1 : 0;
+    pe.exclude_kernel = 1;
+    pe.exclude_hv = 1;
+    return syscall(__NR_perf_event_open, &pe, 0, -1, -1, 0);
+}
+
+long long perf_counter_read(int fd) {
+    long long count = -1;
+    if (fd < 0 || read(fd, &count, sizeof(count)) != sizeof(count))
+        return -1;
+    return count;
+}
+
+// --------------------------------------------------------------------
+// Counters are registered the first time a thread touches them and are
+// never freed, since OpenMP keeps its pool of threads alive.
+ThreadCounters *instrument_register() {
+    void *mem = NULL;
+    if (posix_memalign(&mem, alignof(ThreadCounters), sizeof(ThreadCounters)) != 0)
+        abort();
+    ThreadCounters *c = static_cast<ThreadCounters *>(mem);
+    memset(c, 0, sizeof(*c));
+    c->cache_fd = hw_counters ? perf_counter_open(PERF_COUNT_HW_CACHE_MISSES, false) : -1;
+    c->branch_fd = hw_counters ? perf_counter_open(PERF_COUNT_HW_BRANCH_MISSES, false) : -1;
+    c->cache_last = perf_counter_read(c->cache_fd);
+    c->branch_last = perf_counter_read(c->branch_fd);
+    {
+        std::lock_guard<std::mutex> guard(registry_lock);
+        registry.push_back(c);
+    }
+    t_counters = c;
+    return c;
+}
+
+void instrument_init(const std::string &profileFile, bool hwCounters) {
+    if (profileFile.empty())
+        return;
+#if !INSTRUMENT
+    LOG_WARN("--profile needs a build with INSTRUMENT=1, nothing will be recorded");
+#endif
+    profile_file = profileFile;
+    hw_counters = hwCounters;
+    samples.clear();
+    memset(instrument_phase_ns, 0, sizeof(instrument_phase_ns));
+    g_instrument_enabled = true;
+
+    // The driving thread registers up front so its counter spans the run.
+    instrument_local();
+    if (hw_counters && t_counters->cache_fd < 0)
+        LOG_WARN("Hardware counters are unavailable, reporting -1");
+}
+
+// Difference since the last read, or -1 once any thread lacks a counter.
+static long long delta(int fd, long long &last, long long sum) {
+    long long now = perf_counter_read(fd);
+    if (now < 0 || sum < 0)
+        return -1;
+    long long d = now - last;
+    last = now;
+    return sum + d;
+}
+
+void instrument_end_tick(int tick, int active) {
+    TickSample s;
+    memset(&s, 0, sizeof(s));
+    s.tick = tick;
+    s.active = active;
+    memcpy(s.phase_ns, instrument_phase_ns, sizeof(s.phase_ns));
+    memset(instrument_phase_ns, 0, sizeof(instrument_phase_ns));
+    s.cache_misses = hw_counters ? 0 : -1;
+    s.branch_misses = hw_counters ? 0 : -1;
+
+    uint64_t busy = 0;
+    std::lock_guard<std::mutex> guard(registry_lock);
+    for (ThreadCounters *c : registry) {
+        s.total.astar_calls += c->astar_calls;
+        s.total.nodes_expanded += c->nodes_expanded;
+        s.total.heap_pushes += c->heap_pushes;
+        s.total.waits += c->waits;
+        s.total.replans += c->replans;
+        s.total.moves += c->moves;
+        s.total.replan_ns += c->replan_ns;
+        s.total.local_reads += c->local_reads;
+        s.total.remote_reads += c->remote_reads;
+        busy += c->busy_ns;
+        if (c->busy_ns > 0)
+            s.threads++;
+        if (hw_counters) {
+            s.cache_misses = delta(c->cache_fd, c->cache_last, s.cache_misses);
+            s.branch_misses = delta(c->branch_fd, c->branch_last, s.branch_misses);
+        }
+        int cacheFd = c->cache_fd, branchFd = c->branch_fd;
+        long long cacheLast = c->cache_last, branchLast = c->branch_last;
+        memset(c, 0, sizeof(*c));
+        c->cache_fd = cacheFd;
+        c->branch_fd = branchFd;
+        c->cache_last = cacheLast;
+        c->branch_last = branchLast;
+    }
+    s.total.busy_ns = busy;
+
+    // The share of the step phase each stepping thread spent on vehicles.
+    uint64_t step = s.phase_ns[PHASE_STEP];
+    s.utilization = (step > 0 && s.threads > 0) ? (double) busy / ((double) step * s.threads) : 0;
+    samples.push_back(s);
+}
+
+void instrument_finish() {
+    if (!g_instrument_enabled)
+        return;
+    g_instrument_enabled = false;
+
+    FILE *out = fopen(profile_file.c_str(), "w");
+    if (out == NULL) {
+        LOG_ERROR("Unable to write profile " << profile_file);
+        return;
+    }
+    fprintf(out, "tick,active,step_s,replan_thread_s,loads_s,output_s,threads,utilization,"
+                 "astar_calls,nodes_expanded,heap_pushes,waits,replans,moves,cache_misses,branch_misses,"
+                 "local_reads,remote_reads\n");
+    TickSample sum;
+    memset(&sum, 0, sizeof(sum));
+    for (const TickSample &s : samples) {
+        fprintf(out, "%d,%d,%.9f,%.9f,%.9f,%.9f,%d,%.4f,%llu,%llu,%llu,%llu,%llu,%llu,%lld,%lld,%llu,%llu\n",
+                s.tick, s.active, s.phase_ns[PHASE_STEP] * 1e-9, s.total.replan_ns * 1e-9,
+                s.phase_ns[PHASE_LOADS] * 1e-9, s.phase_ns[PHASE_OUTPUT] * 1e-9, s.threads,
+                s.utilization, (unsigned long long) s.total.astar_calls,
+                (unsigned long long) s.total.nodes_expanded, (unsigned long long) s.total.heap_pushes,
+                (unsigned long long) s.total.waits, (unsigned long long) s.total.replans,
+                (unsigned long long) s.total.moves, s.cache_misses, s.branch_misses,
+                (unsigned long long) s.total.local_reads, (unsigned long long) s.total.remote_reads);
+        for (int ph = 0; ph < PHASE_COUNT; ph++)
+            sum.phase_ns[ph] += s.phase_ns[ph];
+        sum.total.astar_calls += s.total.astar_calls;
+        sum.total.nodes_expanded += s.total.nodes_expanded;
+        sum.total.replan_ns += s.total.replan_ns;
+        sum.total.busy_ns += s.total.busy_ns;
+        sum.total.local_reads += s.total.local_reads;
+        sum.total.remote_reads += s.total.remote_reads;
+        sum.utilization += s.utilization * s.phase_ns[PHASE_STEP];
+    }
+    fclose(out);
+
+    LOG_INFO("Profile: " << samples.size() << " ticks, step " << sum.phase_ns[PHASE_STEP] * 1e-9
+             << "s (A* " << sum.total.replan_ns * 1e-9 << " thread-s), loads "
+             << sum.phase_ns[PHASE_LOADS] * 1e-9 << "s, output " << sum.phase_ns[PHASE_OUTPUT] * 1e-9
+             << "s, " << (unsigned long) sum.total.astar_calls << " A* calls expanding "
+             << (unsigned long) sum.total.nodes_expanded << " nodes, utilization "
+             << (sum.phase_ns[PHASE_STEP] > 0 ? sum.utilization / sum.phase_ns[PHASE_STEP] : 0));
+    uint64_t reads = sum.total.local_reads + sum.total.remote_reads;
+    if (reads > 0)
+        LOG_INFO("Profile: " << (unsigned long) sum.total.remote_reads << " of " << (unsigned long) reads
+                 << " edge lists read from a remote NUMA node, ratio "
+                 << (double) sum.total.remote_reads / reads);
+    LOG_INFO("Wrote per-tick profile to " << profile_file);
+}
@@ -0,0 +1,191 @@
+/**
+ *          15-418 Final Project
+ *          Title:  Congestion Aware Map Routing
+ *          Credit: Parth Iyer   (pniyer@andrew.cmu.edu)
+ *                  Kwaku Baryeh (kbaryeh@andrew.cmu.edu)
+ */
+
+#ifndef INSTRUMENT_H
+#define INSTRUMENT_H
+
+#include <stdint.h>
+#include <string>
+#include <chrono>
+
+/**
+ * Hot path instrumentation is compiled in with `make INSTRUMENT=1` and then
+ * switched on at runtime with --profile. With the default INSTRUMENT=0 every
+ * INSTR_ macro expands to nothing, so there is no cost at all.
+ */
+#ifndef INSTRUMENT
+#define INSTRUMENT 0
+#endif
+
+/**
+ * @name                InstrPhase
+ * @details             The phases of a tick timed on the driving thread.
+ */
+enum InstrPhase {
+    PHASE_STEP = 0,     // advancing vehicles, including replans
+    PHASE_LOADS,        // update_edge_loads_current
+    PHASE_OUTPUT,       // streaming finished paths, retiring, checkpoints
+    PHASE_COUNT
+};
+
+/**
+ * @name                ThreadCounters
+ * @details             Counters owned by one thread, padded to whole cache
+ *                      lines so threads never write to a shared line. They are
+ *                      summed and reset by instrument_end_tick between ticks.
+ *
+ * @param astar_calls   Searches started
+ * @param nodes_expanded Vertices popped and closed by A*
+ * @param heap_pushes   Entries pushed onto the A* open set
+ * @param waits         Vehicles which waited for a full edge
+ * @param replans       Vehicles which needed a new route
+ * @param moves         Vehicles which advanced one edge
+ * @param replan_ns     Time spent in A*
+ * @param busy_ns       Time spent stepping vehicles
+ * @param local_reads   Edge lists A* read from its thread's own NUMA node
+ * @param remote_reads  Edge lists A* read from another node (see numa.h)
+ */
+struct alignas(64) ThreadCounters {
+    uint64_t astar_calls;
+    uint64_t nodes_expanded;
+    uint64_t heap_pushes;
+    uint64_t waits;
+    uint64_t replans;
+    uint64_t moves;
+    uint64_t replan_ns;
+    uint64_t busy_ns;
+    uint64_t local_reads;
+    uint64_t remote_reads;
+    int cache_fd;
+    int branch_fd;
+    long long cache_last;
+    long long branch_last;
+};
+
+extern bool g_instrument_enabled;
+extern thread_local ThreadCounters *t_counters;
+
+/**
+ * The NUMA node owning each vertex's edge list and the node of the calling
+ * thread, set by the NUMA placement; NULL when the graph is not placed.
+ */
+extern const int *instrument_vertex_node;
+extern thread_local int t_instrument_node;
+
+/**
+ * @name                instrument_register
+ * @details             Allocates and registers the calling thread's counters.
+ */
+ThreadCounters *instrument_register();
+
+inline ThreadCounters &instrument_local() {
+    return *(t_counters != NULL ? t_counters : instrument_register());
+}
+
+inline uint64_t instrument_now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @name                InstrScope
+ * @details             Adds the lifetime of the scope to a counter, if any.
+ */
+struct InstrScope {
+    uint64_t *target;
+    uint64_t start;
+
+    explicit InstrScope(uint64_t *t) : target(t), start(t != NULL ? instrument_now_ns() : 0) {}
+    ~InstrScope() {
+        if (target != NULL)
+            *target += instrument_now_ns() - start;
+    }
+};
+
+/**
+ * @name                instrument_phase_ns
+ * @details             The phase times of the current tick, only written by
+ *                      the driving thread.
+ */
+extern uint64_t instrument_phase_ns[PHASE_COUNT];
+
+#define INSTR_CONCAT_(a, b) a##b
+#define INSTR_CONCAT(a, b) INSTR_CONCAT_(a, b)
+
+#if INSTRUMENT
+#define INSTR_COUNT(field, n) \
+    do { if (g_instrument_enabled) instrument_local().field += (n); } while (0)
+#define INSTR_TIME(field) \
+    InstrScope INSTR_CONCAT(instr_scope_, __LINE__)(g_instrument_enabled ? &instrument_local().field : NULL)
+#define INSTR_PHASE(phase) \
+    InstrScope INSTR_CONCAT(instr_phase_, __LINE__)(g_instrument_enabled ? &instrument_phase_ns[phase] : NULL)
+#define INSTR_END_TICK(tick, active) \
+    do { if (g_instrument_enabled) instrument_end_tick(tick, active); } while (0)
+#define INSTR_NODE_READ(v) \
+    do { \
+        if (g_instrument_enabled && instrument_vertex_node != NULL) { \
+            ThreadCounters &instr_c = instrument_local(); \
+            if (instrument_vertex_node[v] == t_instrument_node) \
+                instr_c.local_reads++; \
+            else \
+                instr_c.remote_reads++; \
+        } \
+    } while (0)
+#else
+#define INSTR_COUNT(field, n) do {} while (0)
+#define INSTR_TIME(field) do {} while (0)
+#define INSTR_PHASE(phase) do {} while (0)
+#define INSTR_END_TICK(tick, active) do {} while (0)
+#define INSTR_NODE_READ(v) do {} while (0)
+#endif
+
+/**
+ * @name                instrument_init
+ * @details             Enables the instrumentation when `profileFile` is not
+ *                      empty. Warns if the build has INSTRUMENT=0.
+ *
+ * @param[in] profileFile  Where instrument_finish writes the per-tick CSV
+ * @param[in] hwCounters   Also count cache and branch misses per thread
+ */
+void instrument_init(const std::string &profileFile, bool hwCounters);
+
+/**
+ * @name                instrument_end_tick
+ * @details             Sums and resets every thread's counters and phase times
+ *                      into one row of the time series. Call between ticks,
+ *                      when no other thread is updating its counters.
+ *
+ * @param[in] tick      The tick which just finished
+ * @param[in] active    The number of vehicles stepped in it
+ */
+void instrument_end_tick(int tick, int active);
+
+/**
+ * @name                instrument_finish
+ * @details             Writes the time series and logs totals, then disables
+ *                      the instrumentation.
+ */
+void instrument_finish();
+
+/**
+ * @name                perf_counter_open
+ * @details             Opens an enabled hardware counter for the calling thread
+ *                      through perf_event_open.
+ *
+ * @param[in] config    A PERF_COUNT_HW_* event
+ * @param[in] inherit   Also count children created after the call
+ * @return              The counter's descriptor or -1 if unavailable
+ */
+int perf_counter_open(uint64_t config, bool inherit);
+
+/**
+ * @name                perf_counter_read
+ * @return              The current count, or -1 for a bad descriptor
+ */
+long long perf_counter_read(int fd);
+
+#endif // INSTRUMENT_H
@@ -0,0 +1,228 @@
+/**
+ *          15-418 Final Project
+ *          Title:  Congestion Aware Map Routing
+ *          Credit: Parth Iyer   (pniyer@andrew.cmu.edu)
+ *                  Kwaku Baryeh (kbaryeh@andrew.cmu.edu)
+ */
+
+#include "log.h"
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+#include <cstdlib>
+#include <stdio.h>
+
+int g_log_level = LOG_LEVEL_INFO;
+bool g_trace_enabled = false;
+
+/**
+ * @name                RingBuffer
+ * @details             Single producer / single consumer byte ring. The owning
+ *                      thread appends, the flusher thread drains. Neither side
+ *                      takes a lock.
+ */
+struct RingBuffer {
+    static const size_t SIZE = 1 << 20;
+
+    std::atomic<size_t> head;   // Written by the producer.
+    char pad0[64];
+    std::atomic<size_t> tail;   // Written by the consumer.
+    char pad1[64];
+    char data[SIZE];
+
+    RingBuffer() : head(0), tail(0) {}
+
+    size_t free_space() const {
+        return SIZE - (head.load(std::memory_order_relaxed) - tail.load(std::memory_order_acquire));
+    }
+
+    void push(const char *src, size_t len) {
+        size_t h = head.load(std::memory_order_relaxed);
+        size_t off = h & (SIZE - 1);
+        size_t first = std::min(len, SIZE - off);
+        memcpy(data + off, src, first);
+        memcpy(data, src + first, len - first);
+        head.store(h + len, std::memory_order_release);
+    }
+
+    // Writes everything which is committed to `out`.
+    void drain(FILE *out) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t h = head.load(std::memory_order_acquire);
+        while (t != h) {
+            size_t off = t & (SIZE - 1);
+            size_t len = std::min(h - t, SIZE - off);
+            fwrite(data + off, 1, len, out);
+            t += len;
+        }
+        tail.store(t, std::memory_order_release);
+    }
+};
+
+struct ThreadBuffers {
+    RingBuffer text;
+    RingBuffer trace;
+};
+
+static std::mutex registry_lock;
+static std::vector<ThreadBuffers *> registry;
+static std::thread flusher;
+static std::atomic<bool> flusher_running(false);
+static FILE *trace_file = NULL;
+
+static thread_local ThreadBuffers *local_buffers = NULL;
+static thread_local std::string local_line;
+
+static ThreadBuffers *get_buffers() {
+    if (local_buffers == NULL) {
+        local_buffers = new ThreadBuffers();
+        std::lock_guard<std::mutex> guard(registry_lock);
+        registry.push_back(local_buffers);
+    }
+    return local_buffers;
+}
+
+static void drain_all() {
+    std::lock_guard<std::mutex> guard(registry_lock);
+    for (ThreadBuffers *b : registry) {
+        b->text.drain(stderr);
+        if (trace_file != NULL)
+            b->trace.drain(trace_file);
+    }
+    fflush(stderr);
+    if (trace_file != NULL)
+        fflush(trace_file);
+}
+
+static void flush_loop() {
+    while (flusher_running.load(std::memory_order_acquire)) {
+        drain_all();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+// Copies a record into a ring, waiting for the flusher when the ring is full.
+static void commit(RingBuffer &ring, const char *src, size_t len) {
+    while (len > 0) {
+        size_t chunk = std::min(len, RingBuffer::SIZE / 2);
+        while (ring.free_space() < chunk) {
+            if (!flusher_running.load(std::memory_order_acquire))
+                drain_all();
+            std::this_thread::yield();
+        }
+        ring.push(src, chunk);
+        src += chunk;
+        len -= chunk;
+    }
+}
+
+static const char *level_tag(int level) {
+    switch (level) {
+        case LOG_LEVEL_ERROR: return "[ERROR] ";
+        case LOG_LEVEL_WARN:  return "[WARN] ";
+        case LOG_LEVEL_DEBUG: return "[DEBUG] ";
+        case LOG_LEVEL_TRACE: return "[TRACE] ";
+        default:              return "";
+    }
+}
+
+LogLine::LogLine(int level) : line(local_line) {
+    line.clear();
+    line += level_tag(level);
+}
+
+LogLine::~LogLine() {
+    line += '\n';
+    if (flusher_running.load(std::memory_order_relaxed)) {
+        commit(get_buffers()->text, line.data(), line.size());
+    } else {
+        fwrite(line.data(), 1, line.size(), stderr);
+    }
+}
+
+LogLine &LogLine::operator<<(const char *s) { line += s; return *this; }
+LogLine &LogLine::operator<<(const std::string &s) { line += s; return *this; }
+LogLine &LogLine::operator<<(char c) { line += c; return *this; }
+
+LogLine &LogLine::operator<<(int v) {
+    char buf[16];
+    int n = snprintf(buf, sizeof(buf), "%d", v);
+    line.append(buf, n);
+    return *this;
+}
+
+LogLine &LogLine::operator<<(long v) {
+    char buf[24];
+    int n = snprintf(buf, sizeof(buf), "%ld", v);
+    line.append(buf, n);
+    return *this;
+}
+
+LogLine &LogLine::operator<<(unsigned long v) {
+    char buf[24];
+    int n = snprintf(buf, sizeof(buf), "%lu", v);
+    line.append(buf, n);
+    return *this;
+}
+
+LogLine &LogLine::operator<<(double v) {
+    char buf[32];
+    int n = snprintf(buf, sizeof(buf), "%g", v);
+    line.append(buf, n);
+    return *this;
+}
+
+LogLine &LogLine::operator<<(const std::vector<int> &v) {
+    for (size_t i = 0; i < v.size(); i++) {
+        if (i > 0)
+            line += ' ';
+        *this << v[i];
+    }
+    return *this;
+}
+
+void trace_event(int tick, int vehicle, int event, int a, int b) {
+    TraceRecord r = {tick, vehicle, event, a, b};
+    if (flusher_running.load(std::memory_order_relaxed))
+        commit(get_buffers()->trace, (const char *) &r, sizeof(r));
+    else if (trace_file != NULL)
+        fwrite(&r, sizeof(r), 1, trace_file);
+}
+
+int parse_log_level(const std::string &name) {
+    static const char *names[] = {"off", "error", "warn", "info", "debug", "trace"};
+    for (int i = 0; i <= LOG_LEVEL_TRACE; i++)
+        if (name == names[i])
+            return i;
+    if (name.size() == 1 && name[0] >= '0' && name[0] <= '5')
+        return name[0] - '0';
+    return -1;
+}
+
+void log_init(int level, const std::string &trace) {
+    g_log_level = level;
+    if (!trace.empty()) {
+        trace_file = fopen(trace.c_str(), "wb");
+        if (trace_file == NULL)
+            fprintf(stderr, "Unable to open trace file %s\n", trace.c_str());
+        g_trace_enabled = trace_file != NULL;
+    }
+    if (!flusher_running.exchange(true)) {
+        flusher = std::thread(flush_loop);
+        atexit(log_shutdown);
+    }
+}
+
+void log_shutdown() {
+    if (flusher_running.exchange(false))
+        flusher.join();
+    drain_all();
+    if (trace_file != NULL) {
+        fclose(trace_file);
+        trace_file = NULL;
+        g_trace_enabled = false;
+    }
+}
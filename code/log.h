@@ -0,0 +1,167 @@
+/**
+ *          15-418 Final Project
+ *          Title:  Congestion Aware Map Routing
+ *          Credit: Parth Iyer   (pniyer@andrew.cmu.edu)
+ *                  Kwaku Baryeh (kbaryeh@andrew.cmu.edu)
+ */
+
+#ifndef LOG_H
+#define LOG_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#define LOG_LEVEL_OFF   0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN  2
+#define LOG_LEVEL_INFO  3
+#define LOG_LEVEL_DEBUG 4
+#define LOG_LEVEL_TRACE 5
+
+/**
+ * Messages above LOG_COMPILE_LEVEL are removed by the preprocessor, so their
+ * arguments are never evaluated. Build with `make LOG_LEVEL=5` to keep the
+ * per-vehicle debug and trace output available at runtime.
+ */
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL LOG_LEVEL_INFO
+#endif
+
+extern int g_log_level;
+extern bool g_trace_enabled;
+
+inline bool log_enabled(int level) {
+    return level <= g_log_level;
+}
+
+/**
+ * @name                LogLine
+ * @details             Formats one log line into a thread local scratch string
+ *                      and hands it to the calling thread's buffer when it goes
+ *                      out of scope. Only whole lines are ever flushed, so
+ *                      lines from different threads never interleave.
+ */
+class LogLine {
+public:
+    explicit LogLine(int level);
+    ~LogLine();
+
+    LogLine &operator<<(const char *s);
+    LogLine &operator<<(const std::string &s);
+    LogLine &operator<<(char c);
+    LogLine &operator<<(int v);
+    LogLine &operator<<(long v);
+    LogLine &operator<<(unsigned long v);
+    LogLine &operator<<(double v);
+    LogLine &operator<<(const std::vector<int> &v);
+
+private:
+    std::string &line;
+};
+
+#define LOG_AT(level, msg) \
+    do { if (log_enabled(level)) { LogLine(level) << msg; } } while (0)
+
+#if LOG_COMPILE_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(msg) LOG_AT(LOG_LEVEL_ERROR, msg)
+#else
+#define LOG_ERROR(msg) do {} while (0)
+#endif
+
+#if LOG_COMPILE_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(msg) LOG_AT(LOG_LEVEL_WARN, msg)
+#else
+#define LOG_WARN(msg) do {} while (0)
+#endif
+
+#if LOG_COMPILE_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(msg) LOG_AT(LOG_LEVEL_INFO, msg)
+#else
+#define LOG_INFO(msg) do {} while (0)
+#endif
+
+#if LOG_COMPILE_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(msg) LOG_AT(LOG_LEVEL_DEBUG, msg)
+#else
+#define LOG_DEBUG(msg) do {} while (0)
+#endif
+
+#if LOG_COMPILE_LEVEL >= LOG_LEVEL_TRACE
+#define LOG_TRACE(msg) LOG_AT(LOG_LEVEL_TRACE, msg)
+#else
+#define LOG_TRACE(msg) do {} while (0)
+#endif
+
+/**
+ * @name                TraceEvent
+ * @details             Event kinds recorded in the binary trace.
+ */
+enum TraceEvent {
+    TRACE_ADVANCE  = 1,  // a = from vertex, b = to vertex
+    TRACE_WAIT     = 2,  // a = vertex, b = blocked next vertex
+    TRACE_REPLAN   = 3,  // a = vertex, b = new route length
+    TRACE_ARRIVE   = 4,  // a = vertex
+    TRACE_STUCK    = 5,  // a = vertex
+    TRACE_DEPART   = 6,  // a = vertex
+    TRACE_GRIDLOCK = 7   // a = vertex, b = blocked next vertex
+};
+
+/**
+ * @name                TraceRecord
+ * @details             A fixed size, little endian record of the binary trace
+ *                      file. The file is a plain sequence of these records.
+ */
+struct TraceRecord {
+    int32_t tick;
+    int32_t vehicle;
+    int32_t event;
+    int32_t a;
+    int32_t b;
+};
+
+/**
+ * Trace records are only produced when a trace file was opened with
+ * log_init(). Build with -DLOG_NO_TRACE to remove them entirely.
+ */
+#ifndef LOG_NO_TRACE
+#define TRACE_EVENT(tick, vehicle, event, a, b) \
+    do { if (g_trace_enabled) trace_event(tick, vehicle, event, a, b); } while (0)
+#else
+#define TRACE_EVENT(tick, vehicle, event, a, b) do {} while (0)
+#endif
+
+/**
+ * @name                trace_event
+ * @details             Appends a record to the calling thread's trace buffer.
+ */
+void trace_event(int tick, int vehicle, int event, int a, int b);
+
+/**
+ * @name                parse_log_level
+ * @details             Parses a level name (off, error, warn, info, debug,
+ *                      trace) or number.
+ *
+ * @return              The level or -1 if the name is unknown
+ */
+int parse_log_level(const std::string &name);
+
+/**
+ * @name                log_init
+ * @details             Sets the runtime level and starts the background thread
+ *                      which drains the per-thread buffers. Until this is
+ *                      called lines are written synchronously.
+ *
+ * @param[in] level     The most verbose level which is printed
+ * @param[in] trace     A file for the binary trace, or empty for none
+ */
+void log_init(int level, const std::string &trace);
+
+/**
+ * @name                log_shutdown
+ * @details             Stops the flusher thread and writes out everything which
+ *                      is still buffered. Registered with atexit by log_init.
+ */
+void log_shutdown();
+
+#endif // LOG_H
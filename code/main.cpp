@@ -14,6 +14,7 @@ int main(int argc, char *argv[]) {
 
     print_graph(p.graph);
 
+    p.graph.adj = calculate_adj_matrix(p.graph.edges);
     print_adj_mat(p.graph.adj);
 
     save_problem(p);
@@ -1,9 +1,30 @@
+import csv, sys
 import matplotlib.pyplot as plt
 
-# Data for cache misses
-difficulties = ['Easy', 'Medium', 'Hard']
-sequential_cache_misses = [6_395_607, 6_427_554, 11_238_606]
-parallel_cache_misses   = [12_779_811, 12_004_482, 34_762_212]
+# Reads the cache misses recorded by `./bench --csv bench.csv` for the
+# end-to-end runs; the parallel run with the most threads is shown.
+# Usage: python3 misses.py [bench.csv]
+results_file = sys.argv[1] if len(sys.argv) > 1 else 'bench.csv'
+
+sequential = {}
+parallel = {}   # input -> (threads, misses)
+with open(results_file) as f:
+    for row in csv.DictReader(f):
+        misses = int(row['cache_misses'])
+        if misses < 0:
+            continue
+        if row['benchmark'] == 'sequential':
+            sequential[row['input']] = misses
+        elif row['benchmark'] == 'parallel':
+            threads = int(row['threads'])
+            if threads >= parallel.get(row['input'], (0, 0))[0]:
+                parallel[row['input']] = (threads, misses)
+
+difficulties = [i for i in sequential if i in parallel]
+if not difficulties:
+    sys.exit(f'No cache miss counts in {results_file} (are perf events available?)')
+sequential_cache_misses = [sequential[i] for i in difficulties]
+parallel_cache_misses   = [parallel[i][1] for i in difficulties]
 
 x = range(len(difficulties))
 
@@ -11,14 +32,12 @@ plt.figure(figsize=(8, 6))
 plt.bar(x, sequential_cache_misses, width=0.4, label='Sequential', align='center')
 plt.bar([i + 0.4 for i in x], parallel_cache_misses,   width=0.4, label='Parallel',   align='center')
 
-plt.xlabel('Difficulty Level')
+plt.xlabel('Input')
 plt.ylabel('Cache Misses')
-plt.title('Cache Misses by Difficulty (Sequential vs Parallel)')
+plt.title('Cache Misses by Input (Sequential vs Parallel)')
 plt.xticks([i + 0.2 for i in x], difficulties)
 plt.legend()
 plt.grid(axis='y', linestyle='--', alpha=0.6)
 plt.tight_layout()
 
 plt.savefig('cache_misses.png', dpi=300)
-
-
@@ -0,0 +1,219 @@
+/**
+ *          15-418 Final Project
+ *          Title:  Congestion Aware Map Routing
+ *          Credit: Parth Iyer   (pniyer@andrew.cmu.edu)
+ *                  Kwaku Baryeh (kbaryeh@andrew.cmu.edu)
+ */
+
+#include "numa.h"
+#include "partition.h"
+#include "instrument.h"
+#include "arena.h"
+#include "log.h"
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <cstring>
+
+static const char *NODE_DIR = "/sys/devices/system/node";
+
+bool parse_numa_mode(const std::string &mode, int &nodes) {
+    if (mode == "off") {
+        nodes = 0;
+    } else if (mode == "auto") {
+        nodes = -1;
+    } else {
+        char *end = NULL;
+        long n = strtol(mode.c_str(), &end, 10);
+        if (end == mode.c_str() || *end != '\0' || n < 1 || n > 1024)
+            return false;
+        nodes = n;
+    }
+    return true;
+}
+
+// Parses a kernel CPU or node list such as "0-3,8-11".
+static std::vector<int> parse_id_list(const std::string &list) {
+    std::vector<int> ids;
+    std::stringstream ss(list);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        int lo, hi;
+        int fields = sscanf(item.c_str(), "%d-%d", &lo, &hi);
+        if (fields == 1)
+            hi = lo;
+        else if (fields != 2)
+            continue;
+        for (int id = lo; id <= hi; id++)
+            ids.push_back(id);
+    }
+    return ids;
+}
+
+static std::vector<int> allowed_cpus() {
+    std::vector<int> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+            if (CPU_ISSET(cpu, &set))
+                cpus.push_back(cpu);
+    }
+    if (cpus.empty())
+        cpus.push_back(0);
+    return cpus;
+}
+
+bool detect_numa_topology(NumaTopology &topology) {
+    topology.cpus.clear();
+    topology.os_node.clear();
+    std::ifstream online(std::string(NODE_DIR) + "/online");
+    std::string list;
+    if (!online || !std::getline(online, list))
+        return false;
+
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    for (int cpu : allowed_cpus())
+        CPU_SET(cpu, &allowed);
+    for (int node : parse_id_list(list)) {
+        std::ifstream in(std::string(NODE_DIR) + "/node" + std::to_string(node) + "/cpulist");
+        std::string cpuList;
+        if (!in || !std::getline(in, cpuList))
+            continue;
+        std::vector<int> cpus;
+        for (int cpu : parse_id_list(cpuList))
+            if (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed))
+                cpus.push_back(cpu);
+        // Memory-only nodes and nodes outside our mask run no workers.
+        if (cpus.empty())
+            continue;
+        topology.cpus.push_back(cpus);
+        topology.os_node.push_back(node);
+    }
+    return !topology.cpus.empty();
+}
+
+void simulate_numa_topology(NumaTopology &topology, int nodes) {
+    std::vector<int> cpus = allowed_cpus();
+    int n = cpus.size();
+    topology.cpus.assign(nodes, std::vector<int>());
+    topology.os_node.assign(nodes, -1);
+    for (int r = 0; r < nodes; r++) {
+        if (n >= nodes) {
+            topology.cpus[r].assign(cpus.begin() + (long) n * r / nodes, cpus.begin() + (long) n * (r + 1) / nodes);
+        } else {
+            topology.cpus[r].push_back(cpus[r % n]);
+        }
+    }
+}
+
+bool init_numa_placement(NumaPlacement &numa, const Graph &graph, int mode, int workers) {
+    if (mode == 0)
+        return false;
+    if (mode > 0) {
+        simulate_numa_topology(numa.topology, mode);
+    } else if (!detect_numa_topology(numa.topology)) {
+        LOG_WARN("Unable to read the NUMA topology from " << NODE_DIR << ", not placing the graph");
+        return false;
+    } else if (numa.topology.nodes() < 2) {
+        LOG_INFO("NUMA: one node, nothing to place");
+        return false;
+    }
+
+    int nodes = numa.topology.nodes();
+    numa.region = partition_by_coordinates(graph, nodes);
+    numa.worker_node.resize(workers);
+    numa.worker_cpu.resize(workers);
+    numa.saved.resize(workers);
+    // Consecutive workers share a node, and spread over its CPUs. With fewer
+    // workers than nodes, the nodes past the last worker's get none.
+    int first = 0;
+    for (int w = 0; w < workers; w++) {
+        int node = (long) w * nodes / workers;
+        if (w == 0 || node != numa.worker_node[w - 1])
+            first = w;
+        const std::vector<int> &cpus = numa.topology.cpus[node];
+        numa.worker_node[w] = node;
+        numa.worker_cpu[w] = cpus[(w - first) % cpus.size()];
+    }
+    numa.start.assign(nodes + 1, 0);
+    numa.cursor = std::vector<NumaCursor>(nodes);
+    numa.local_steps = numa.stolen_steps = 0;
+    numa.pinned = 0;
+    return true;
+}
+
+// The worker which copies the edge lists of `node`: the node's first, or
+// for a node without workers, one picked round robin.
+static int placer(const NumaPlacement &numa, int node) {
+    int workers = numa.worker_node.size();
+    for (int w = 0; w < workers; w++)
+        if (numa.worker_node[w] == node)
+            return w;
+    return node % workers;
+}
+
+void place_worker(NumaPlacement &numa, Graph &graph, int worker) {
+    t_instrument_node = numa.worker_node[worker];
+    CPU_ZERO(&numa.saved[worker]);
+    sched_getaffinity(0, sizeof(cpu_set_t), &numa.saved[worker]);
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(numa.worker_cpu[worker], &set);
+    if (sched_setaffinity(0, sizeof(set), &set) == 0)
+        numa.pinned++;
+
+    // Copy the lists from the pinned thread, so it touches their pages first.
+    int n = graph.edges.size();
+    for (int node = 0; node < numa.topology.nodes(); node++) {
+        if (placer(numa, node) != worker)
+            continue;
+        use_arena_node(node);
+        for (int v = 0; v < n; v++) {
+            if (numa.region[v] != node)
+                continue;
+            EdgeList local(graph.edges[v].begin(), graph.edges[v].end());
+            graph.edges[v].swap(local);
+        }
+        use_arena_node(-1);
+    }
+}
+
+void unpin_worker(NumaPlacement &numa, int worker) {
+    sched_setaffinity(0, sizeof(cpu_set_t), &numa.saved[worker]);
+    t_instrument_node = 0;
+}
+
+void schedule_by_region(NumaPlacement &numa, const VehicleTable &vt) {
+    int nodes = numa.topology.nodes();
+    int n = vt.active.size();
+    std::fill(numa.start.begin(), numa.start.end(), 0);
+    for (int k = 0; k < n; k++)
+        numa.start[numa.region[vt.position[vt.active[k]]] + 1]++;
+    for (int r = 0; r < nodes; r++) {
+        numa.start[r + 1] += numa.start[r];
+        numa.cursor[r].next.store(numa.start[r], std::memory_order_relaxed);
+    }
+    numa.order.resize(n);
+    // The cursors count up to each node's end here, and are reset after.
+    for (int k = 0; k < n; k++)
+        numa.order[numa.cursor[numa.region[vt.position[vt.active[k]]]].next++] = k;
+    for (int r = 0; r < nodes; r++)
+        numa.cursor[r].next.store(numa.start[r], std::memory_order_relaxed);
+}
+
+void report_numa_placement(const NumaPlacement &numa) {
+    int nodes = numa.topology.nodes();
+    std::ostringstream sizes;
+    std::vector<long> count(nodes, 0);
+    for (int r : numa.region)
+        count[r]++;
+    for (int r = 0; r < nodes; r++)
+        sizes << (r ? "/" : "") << count[r];
+    unsigned long local = numa.local_steps, stolen = numa.stolen_steps;
+    LOG_INFO("NUMA: " << nodes << (numa.topology.os_node[0] < 0 ? " simulated" : "") << " nodes with "
+             << sizes.str() << " vertices, " << (int) numa.pinned << " of "
+             << (unsigned long) numa.worker_node.size() << " workers pinned, "
+             << local << " of " << local + stolen << " vehicle steps on their region's node");
+}
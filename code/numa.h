@@ -0,0 +1,174 @@
+/**
+ *          15-418 Final Project
+ *          Title:  Congestion Aware Map Routing
+ *          Credit: Parth Iyer   (pniyer@andrew.cmu.edu)
+ *                  Kwaku Baryeh (kbaryeh@andrew.cmu.edu)
+ */
+
+#ifndef NUMA_H
+#define NUMA_H
+
+#include "graph.h"
+#include "vehicles.h"
+#include <string>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <sched.h>
+
+/**
+ * NUMA-aware placement for the OpenMP engine. load_problem runs on one
+ * thread, so without it every page of the graph sits on that thread's node
+ * and the workers of the other nodes read all of it remotely. With --numa the
+ * vertices are split into one region per node by recursive coordinate
+ * bisection, each worker is pinned to a CPU of a node, and a worker of each
+ * node copies its region's edge lists into that node's arena chunks (see
+ * use_arena_node), so the kernel's first-touch policy puts them on the node.
+ * Each tick, a worker steps the vehicles standing in its node's region first
+ * and only then takes those of other nodes.
+ *
+ * The topology comes from /sys/devices/system/node, or is simulated by
+ * splitting the CPUs this process may run on into N nodes, so the placement
+ * and scheduling can be exercised on a single-node machine. The vertex
+ * coordinates and the vehicle table are indexed by id, not region, and stay
+ * where they are.
+ */
+
+// Vehicle slots a worker claims at a time.
+const int NUMA_CLAIM = 8;
+
+/**
+ * @name                NumaTopology
+ * @param cpus          The CPUs of each node this process may run on
+ * @param os_node       The kernel's number of each node, or -1 if simulated
+ */
+struct NumaTopology {
+    std::vector<std::vector<int>> cpus;
+    std::vector<int> os_node;
+
+    int nodes() const {
+        return cpus.size();
+    }
+};
+
+/**
+ * @name                NumaCursor
+ * @details             The next unclaimed slot of a node's share of the
+ *                      tick. Padded so that two cursors never share a cache
+ *                      line.
+ */
+struct NumaCursor {
+    std::atomic<int> next;
+    char pad[CACHE_LINE_SIZE];
+};
+
+/**
+ * @name                NumaPlacement
+ * @param topology      The nodes and their CPUs
+ * @param region        The node owning each vertex
+ * @param worker_node   The node of each worker
+ * @param worker_cpu    The CPU each worker is pinned to
+ * @param saved         Each worker's CPU mask before pinning
+ * @param order         This tick's active slots, grouped by node
+ * @param start         The first entry of each node in `order`, and the end
+ * @param cursor        How far each node's share has been claimed
+ * @param local_steps   Vehicles stepped by a worker of their region's node
+ * @param stolen_steps  Vehicles stepped by a worker of another node
+ * @param pinned        Workers pinned successfully
+ */
+struct NumaPlacement {
+    NumaTopology topology;
+    std::vector<int> region;
+    std::vector<int> worker_node;
+    std::vector<int> worker_cpu;
+    std::vector<cpu_set_t> saved;
+    std::vector<int> order;
+    std::vector<int> start;
+    std::vector<NumaCursor> cursor;
+    std::atomic<unsigned long> local_steps;
+    std::atomic<unsigned long> stolen_steps;
+    std::atomic<int> pinned;
+
+    NumaPlacement() : local_steps(0), stolen_steps(0), pinned(0) {}
+};
+
+/**
+ * @name                parse_numa_mode
+ * @details             Maps off to 0, auto (the machine's topology) to -1 and
+ *                      a positive count to that many simulated nodes.
+ *
+ * @return              false if the mode is neither
+ */
+bool parse_numa_mode(const std::string &mode, int &nodes);
+
+/**
+ * @name                detect_numa_topology
+ * @return              false if /sys/devices/system/node cannot be read
+ */
+bool detect_numa_topology(NumaTopology &topology);
+
+/**
+ * @name                simulate_numa_topology
+ * @details             Splits the CPUs this process may run on into `nodes`
+ *                      consecutive groups; with fewer CPUs than nodes, nodes
+ *                      share them.
+ */
+void simulate_numa_topology(NumaTopology &topology, int nodes);
+
+/**
+ * @name                init_numa_placement
+ * @details             Picks the topology for `mode` (see parse_numa_mode),
+ *                      partitions the vertices and assigns the workers to
+ *                      nodes in blocks of consecutive ids.
+ *
+ * @return              false if there is nothing to place: the mode is off,
+ *                      or auto found a single node
+ */
+bool init_numa_placement(NumaPlacement &numa, const Graph &graph, int mode, int workers);
+
+/**
+ * @name                place_worker
+ * @details             Pins the calling thread, worker `worker`, to its CPU
+ *                      and copies the edge lists of the regions it places
+ *                      into its node's chunks: those of its node if it is the
+ *                      node's first worker, and those of the nodes no worker
+ *                      is on. Every worker calls it once, at the same time.
+ */
+void place_worker(NumaPlacement &numa, Graph &graph, int worker);
+
+/**
+ * @name                unpin_worker
+ * @details             Gives worker `worker` its CPU mask back.
+ */
+void unpin_worker(NumaPlacement &numa, int worker);
+
+/**
+ * @name                schedule_by_region
+ * @details             Groups this tick's active slots by the region their
+ *                      vehicle stands in and resets the cursors.
+ */
+void schedule_by_region(NumaPlacement &numa, const VehicleTable &vt);
+
+/**
+ * @name                claim_slots
+ * @details             Claims up to NUMA_CLAIM entries of node's share of
+ *                      `order`, from `begin` on.
+ *
+ * @return              The number claimed, 0 once the share is gone
+ */
+inline int claim_slots(NumaPlacement &numa, int node, int &begin) {
+    int end = numa.start[node + 1];
+    if (numa.cursor[node].next.load(std::memory_order_relaxed) >= end)
+        return 0;
+    begin = numa.cursor[node].next.fetch_add(NUMA_CLAIM, std::memory_order_relaxed);
+    return begin < end ? std::min(NUMA_CLAIM, end - begin) : 0;
+}
+
+/**
+ * @name                report_numa_placement
+ * @details             Logs the nodes, the workers pinned and the share of
+ *                      vehicles stepped on their region's node.
+ */
+void report_numa_placement(const NumaPlacement &numa);
+
+#endif // NUMA_H
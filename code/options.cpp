@@ -0,0 +1,212 @@
+/**
+ *          15-418 Final Project
+ *          Title:  Congestion Aware Map Routing
+ *          Credit: Parth Iyer   (pniyer@andrew.cmu.edu)
+ *                  Kwaku Baryeh (kbaryeh@andrew.cmu.edu)
+ */
+
+#include "options.h"
+#include "log.h"
+#include "arena.h"
+#include "numa.h"
+#include <cstdlib>
+#include <cstring>
+#include <stdio.h>
+
+SimOptions::SimOptions()
+    : log_level(LOG_LEVEL_INFO), output_format(FORMAT_TEXT), checkpoint_every(100),
+      ranks(1), scaling(false), perf_counters(false), router("astar"),
+      router_budget_mb(512), apsp_method("auto"),
+      overlay_cell(64), overlay_levels(3), edge_cost("static"), reroute_slack(-1), speculate(true),
+      epsilon(0), route_budget_us(0), gap_audit(16), batch_jobs(1), threads(0),
+      query_batch(256), gridlock("off"), gridlock_after(20),
+      alternatives(0), alt_stretch(0.3), huge_pages("thp"),
+      numa("off") {}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s <problem_file> [options]\n", prog);
+    fprintf(stderr, "  --log-level L     off, error, warn, info, debug or trace\n");
+    fprintf(stderr, "  --trace FILE      write a binary event trace to FILE\n");
+    fprintf(stderr, "  --output FILE     write the solution to FILE\n");
+    fprintf(stderr, "  --output-format F text (validator.py compatible) or binary\n");
+    fprintf(stderr, "  --checkpoint FILE snapshot the simulation to FILE\n");
+    fprintf(stderr, "  --checkpoint-every N  ticks between snapshots (default 100)\n");
+    fprintf(stderr, "  --resume FILE     continue from a snapshot; use the same --output\n");
+    fprintf(stderr, "  --ranks N         processes for the distributed simulation\n");
+    fprintf(stderr, "  --scaling         report distributed times for 1..N ranks\n");
+    fprintf(stderr, "  --profile FILE    write per-tick phase times and counters (INSTRUMENT=1 builds)\n");
+    fprintf(stderr, "  --perf-counters   add cache and branch misses to the profile\n");
+    fprintf(stderr, "  --router R        astar (default), apsp (all-pairs oracle), auto or overlay\n");
+    fprintf(stderr, "  --router-budget MB  largest oracle --router auto builds (default 512)\n");
+    fprintf(stderr, "  --apsp-method M   auto, floyd or dijkstra\n");
+    fprintf(stderr, "  --overlay-cell N  vertices per cell of the finest overlay level (default 64)\n");
+    fprintf(stderr, "  --overlay-levels L  most overlay levels (default 3)\n");
+    fprintf(stderr, "  --edge-cost M     static (default) or load; used by the astar and overlay routers\n");
+    fprintf(stderr, "  --reroute SLACK   detour around a full edge if at most SLACK longer\n");
+    fprintf(stderr, "  --no-speculation  search detours on demand instead of ahead of time\n");
+    fprintf(stderr, "  --epsilon E       accept A* routes up to 1+E times optimal (weighted A*; default 0, exact)\n");
+    fprintf(stderr, "  --route-budget US spend up to US microseconds a tick refining weighted routes\n");
+    fprintf(stderr, "  --gap-audit N     compare every Nth weighted route with an exact one (default 16)\n");
+    fprintf(stderr, "  --batch FILE      run the scenarios in FILE on the problem's graph (test_parallel);\n");
+    fprintf(stderr, "                    --output is then a prefix of each scenario's solution file\n");
+    fprintf(stderr, "  --batch-jobs J    scenarios run at the same time (default 1)\n");
+    fprintf(stderr, "  --threads T       OpenMP threads per batch scenario (default: cores / J) or of route_server\n");
+    fprintf(stderr, "  --socket PATH     route_server: listen on a Unix socket instead of stdin\n");
+    fprintf(stderr, "  --query-batch N   route_server: most requests answered at once (default 256)\n");
+    fprintf(stderr, "  --events FILE     close, reopen and resize edges at the ticks given in FILE\n");
+    fprintf(stderr, "  --gridlock P      off (default), report, replan or abort when vehicles wait in a ring\n");
+    fprintf(stderr, "  --gridlock-after N  ticks a vehicle of a ring waits before it is a gridlock (default 20)\n");
+    fprintf(stderr, "  --alternatives K  spread popular trips over up to K routes (default 0, off)\n");
+    fprintf(stderr, "  --alt-stretch S   alternatives cost at most 1+S times the shortest route (default 0.3)\n");
+    fprintf(stderr, "  --huge-pages M    back the graph with off (malloc), thp (default) or explicit huge pages\n");
+    fprintf(stderr, "  --numa M          place graph regions and pin workers on NUMA nodes: off (default),\n");
+    fprintf(stderr, "                    auto, or N to simulate N nodes on the CPUs we may use\n");
+}
+
+bool parse_sim_options(int argc, char *argv[], SimOptions &opts) {
+    opts = SimOptions();
+
+    const char *env = getenv("ROUTE_LOG_LEVEL");
+    if (env != NULL && parse_log_level(env) >= 0)
+        opts.log_level = parse_log_level(env);
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (strcmp(arg, "--log-level") == 0 && hasValue) {
+            opts.log_level = parse_log_level(argv[++i]);
+            if (opts.log_level < 0) {
+                fprintf(stderr, "Unknown log level %s\n", argv[i]);
+                return false;
+            }
+        } else if (strcmp(arg, "--trace") == 0 && hasValue) {
+            opts.trace_file = argv[++i];
+        } else if (strcmp(arg, "--output") == 0 && hasValue) {
+            opts.output_file = argv[++i];
+        } else if (strcmp(arg, "--output-format") == 0 && hasValue) {
+            if (!parse_solution_format(argv[++i], opts.output_format)) {
+                fprintf(stderr, "Unknown output format %s\n", argv[i]);
+                return false;
+            }
+        } else if (strcmp(arg, "--checkpoint") == 0 && hasValue) {
+            opts.checkpoint_file = argv[++i];
+        } else if (strcmp(arg, "--checkpoint-every") == 0 && hasValue) {
+            opts.checkpoint_every = atoi(argv[++i]);
+        } else if (strcmp(arg, "--resume") == 0 && hasValue) {
+            opts.resume_file = argv[++i];
+        } else if (strcmp(arg, "--ranks") == 0 && hasValue) {
+            opts.ranks = atoi(argv[++i]);
+        } else if (strcmp(arg, "--scaling") == 0) {
+            opts.scaling = true;
+        } else if (strcmp(arg, "--profile") == 0 && hasValue) {
+            opts.profile_file = argv[++i];
+        } else if (strcmp(arg, "--perf-counters") == 0) {
+            opts.perf_counters = true;
+        } else if (strcmp(arg, "--router") == 0 && hasValue) {
+            opts.router = argv[++i];
+            if (opts.router != "astar" && opts.router != "apsp" && opts.router != "auto" &&
+                opts.router != "overlay") {
+                fprintf(stderr, "Unknown router %s\n", argv[i]);
+                return false;
+            }
+        } else if (strcmp(arg, "--router-budget") == 0 && hasValue) {
+            opts.router_budget_mb = atoi(argv[++i]);
+        } else if (strcmp(arg, "--apsp-method") == 0 && hasValue) {
+            opts.apsp_method = argv[++i];
+            if (opts.apsp_method != "auto" && opts.apsp_method != "floyd" && opts.apsp_method != "dijkstra") {
+                fprintf(stderr, "Unknown APSP method %s\n", argv[i]);
+                return false;
+            }
+        } else if (strcmp(arg, "--overlay-cell") == 0 && hasValue) {
+            opts.overlay_cell = atoi(argv[++i]);
+        } else if (strcmp(arg, "--overlay-levels") == 0 && hasValue) {
+            opts.overlay_levels = atoi(argv[++i]);
+        } else if (strcmp(arg, "--edge-cost") == 0 && hasValue) {
+            opts.edge_cost = argv[++i];
+            if (opts.edge_cost != "static" && opts.edge_cost != "load") {
+                fprintf(stderr, "Unknown edge cost %s\n", argv[i]);
+                return false;
+            }
+        } else if (strcmp(arg, "--reroute") == 0 && hasValue) {
+            opts.reroute_slack = atoi(argv[++i]);
+        } else if (strcmp(arg, "--no-speculation") == 0) {
+            opts.speculate = false;
+        } else if (strcmp(arg, "--epsilon") == 0 && hasValue) {
+            opts.epsilon = atof(argv[++i]);
+            if (opts.epsilon < 0) {
+                fprintf(stderr, "Epsilon must not be negative\n");
+                return false;
+            }
+        } else if (strcmp(arg, "--route-budget") == 0 && hasValue) {
+            opts.route_budget_us = atoi(argv[++i]);
+        } else if (strcmp(arg, "--gap-audit") == 0 && hasValue) {
+            opts.gap_audit = atoi(argv[++i]);
+        } else if (strcmp(arg, "--batch") == 0 && hasValue) {
+            opts.batch_file = argv[++i];
+        } else if (strcmp(arg, "--batch-jobs") == 0 && hasValue) {
+            opts.batch_jobs = atoi(argv[++i]);
+        } else if (strcmp(arg, "--threads") == 0 && hasValue) {
+            opts.threads = atoi(argv[++i]);
+        } else if (strcmp(arg, "--socket") == 0 && hasValue) {
+            opts.socket_path = argv[++i];
+        } else if (strcmp(arg, "--query-batch") == 0 && hasValue) {
+            opts.query_batch = atoi(argv[++i]);
+        } else if (strcmp(arg, "--events") == 0 && hasValue) {
+            opts.events_file = argv[++i];
+        } else if (strcmp(arg, "--gridlock") == 0 && hasValue) {
+            opts.gridlock = argv[++i];
+            if (opts.gridlock != "off" && opts.gridlock != "report" && opts.gridlock != "replan" &&
+                opts.gridlock != "abort") {
+                fprintf(stderr, "Unknown gridlock policy %s\n", argv[i]);
+                return false;
+            }
+        } else if (strcmp(arg, "--gridlock-after") == 0 && hasValue) {
+            opts.gridlock_after = atoi(argv[++i]);
+            if (opts.gridlock_after < 1) {
+                fprintf(stderr, "--gridlock-after must be at least 1\n");
+                return false;
+            }
+        } else if (strcmp(arg, "--alternatives") == 0 && hasValue) {
+            opts.alternatives = atoi(argv[++i]);
+        } else if (strcmp(arg, "--alt-stretch") == 0 && hasValue) {
+            opts.alt_stretch = atof(argv[++i]);
+            if (opts.alt_stretch < 0) {
+                fprintf(stderr, "The alternative stretch must not be negative\n");
+                return false;
+            }
+        } else if (strcmp(arg, "--huge-pages") == 0 && hasValue) {
+            opts.huge_pages = argv[++i];
+            HugePageMode mode;
+            if (!parse_huge_page_mode(opts.huge_pages, mode)) {
+                fprintf(stderr, "Unknown huge page mode %s\n", argv[i]);
+                return false;
+            }
+        } else if (strcmp(arg, "--numa") == 0 && hasValue) {
+            opts.numa = argv[++i];
+            int nodes;
+            if (!parse_numa_mode(opts.numa, nodes)) {
+                fprintf(stderr, "--numa takes off, auto or a number of nodes, not %s\n", argv[i]);
+                return false;
+            }
+        } else if (arg[0] != '-' && opts.problem.empty()) {
+            opts.problem = arg;
+        } else {
+            usage(argv[0]);
+            return false;
+        }
+    }
+
+    if (opts.problem.empty()) {
+        usage(argv[0]);
+        return false;
+    }
+
+    if (opts.log_level > LOG_COMPILE_LEVEL)
+        fprintf(stderr, "Log level %d requested but only levels up to %d were compiled in\n",
+                opts.log_level, LOG_COMPILE_LEVEL);
+    log_init(opts.log_level, opts.trace_file);
+    HugePageMode pages = HUGE_PAGES_THP;
+    parse_huge_page_mode(opts.huge_pages, pages);
+    use_graph_arena(pages);
+    return true;
+}
@@ -0,0 +1,133 @@
+/**
+ *          15-418 Final Project
+ *          Title:  Congestion Aware Map Routing
+ *          Credit: Parth Iyer   (pniyer@andrew.cmu.edu)
+ *                  Kwaku Baryeh (kbaryeh@andrew.cmu.edu)
+ */
+
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include "solution_writer.h"
+#include <string>
+
+/**
+ * @name                SimOptions
+ * @details             Command line options shared by the simulation drivers.
+ *
+ * @param problem       The problem file to load
+ * @param log_level     The most verbose log level printed at runtime
+ * @param trace_file    Where to write the binary event trace (empty for none)
+ * @param output_file   The solution file (empty for the driver's default)
+ * @param output_format The encoding of the solution file
+ * @param checkpoint_file  Where to write checkpoints (empty for none)
+ * @param checkpoint_every Ticks between checkpoints
+ * @param resume_file   A checkpoint to resume from (empty to start fresh)
+ * @param ranks         Number of processes for the distributed simulation
+ * @param scaling       Run the distributed simulation with 1..ranks processes
+ * @param profile_file  Where to write the per-tick instrumentation (empty for none)
+ * @param perf_counters Also record hardware counters in the profile
+ * @param router        astar, apsp (all-pairs distance oracle), auto or overlay
+ * @param router_budget_mb  The largest oracle auto will build, in MB
+ * @param apsp_method   How the oracle is built: auto, floyd or dijkstra
+ * @param overlay_cell  Vertices per cell on the finest overlay level
+ * @param overlay_levels  The most overlay levels to build
+ * @param edge_cost     The routing metric: static or load
+ * @param reroute_slack Detour around a full edge when it costs at most this
+ *                      much more than waiting for it (-1 always waits)
+ * @param speculate     Search detours during the serial phases of a tick
+ * @param epsilon       A* routes may cost up to 1 + epsilon times the exact
+ *                      ones (weighted A*; 0 is exact)
+ * @param route_budget_us  Microseconds a tick may spend after stepping on
+ *                      refining weighted routes with exact searches (0 never
+ *                      refines)
+ * @param gap_audit     Also route every Nth weighted search exactly to measure
+ *                      the cost gap (0 never audits)
+ * @param batch_file    Run the scenarios of this file on the problem's graph
+ *                      instead of one simulation (see run_batch)
+ * @param batch_jobs    Scenarios run at the same time
+ * @param threads       OpenMP threads per scenario (0 splits the cores evenly),
+ *                      or of the route server (0 for the OpenMP default)
+ * @param socket_path   The Unix socket the route server listens on (empty to
+ *                      serve stdin)
+ * @param query_batch   The most requests the route server answers at once
+ * @param events_file   Edge closures and capacity changes to apply during the
+ *                      simulation (empty for none, see events.h)
+ * @param gridlock      What to do about vehicles waiting in a ring: off,
+ *                      report, replan or abort (see gridlock.h)
+ * @param gridlock_after  Ticks a vehicle of a ring waits before it is a
+ *                      gridlock
+ * @param alternatives  Alternative routes per popular trip (below 2 sends
+ *                      every vehicle the shortest way, see alternatives.h)
+ * @param alt_stretch   How much longer than the shortest route an
+ *                      alternative may be, as a fraction
+ * @param huge_pages    What backs the graph storage: off (malloc), thp or
+ *                      explicit huge pages (see arena.h)
+ * @param numa          Place the graph and the workers on NUMA nodes: off,
+ *                      auto (the machine's nodes) or a number of simulated
+ *                      nodes (see numa.h)
+ */
+struct SimOptions {
+    std::string problem;
+    int log_level;
+    std::string trace_file;
+    std::string output_file;
+    SolutionFormat output_format;
+    std::string checkpoint_file;
+    int checkpoint_every;
+    std::string resume_file;
+    int ranks;
+    bool scaling;
+    std::string profile_file;
+    bool perf_counters;
+    std::string router;
+    int router_budget_mb;
+    std::string apsp_method;
+    int overlay_cell;
+    int overlay_levels;
+    std::string edge_cost;
+    int reroute_slack;
+    bool speculate;
+    double epsilon;
+    int route_budget_us;
+    int gap_audit;
+    std::string batch_file;
+    int batch_jobs;
+    int threads;
+    std::string socket_path;
+    int query_batch;
+    std::string events_file;
+    std::string gridlock;
+    int gridlock_after;
+    int alternatives;
+    double alt_stretch;
+    std::string huge_pages;
+    std::string numa;
+
+    SimOptions();
+};
+
+/**
+ * @name                parse_sim_options
+ * @details             Parses `<problem_file> [--log-level L] [--trace FILE]
+ *                      [--output FILE] [--output-format text|binary]
+ *                      [--checkpoint FILE] [--checkpoint-every N] [--resume FILE]
+ *                      [--ranks N] [--scaling] [--profile FILE] [--perf-counters]
+ *                      [--router astar|apsp|auto|overlay] [--router-budget MB]
+ *                      [--apsp-method auto|floyd|dijkstra] [--overlay-cell N]
+ *                      [--overlay-levels L] [--edge-cost static|load] [--reroute SLACK]
+ *                      [--no-speculation] [--epsilon E] [--route-budget US]
+ *                      [--gap-audit N] [--batch FILE] [--batch-jobs J]
+ *                      [--threads T] [--socket PATH] [--query-batch N]
+ *                      [--events FILE] [--gridlock off|report|replan|abort]
+ *                      [--gridlock-after N] [--alternatives K] [--alt-stretch S]
+ *                      [--huge-pages off|thp|explicit] [--numa off|auto|N]`.
+ *                      The ROUTE_LOG_LEVEL environment variable sets the default
+ *                      log level. Starts the logger and picks the graph arena's
+ *                      pages on success, so call it before load_problem.
+ *
+ * @return              false (after printing usage) if the arguments are bad
+ */
+bool parse_sim_options(int argc, char *argv[], SimOptions &opts);
+
+#endif // OPTIONS_H
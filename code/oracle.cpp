@@ -0,0 +1,211 @@
+/**
+ *          15-418 Final Project
+ *          Title:  Congestion Aware Map Routing
+ *          Credit: Parth Iyer   (pniyer@andrew.cmu.edu)
+ *                  Kwaku Baryeh (kbaryeh@andrew.cmu.edu)
+ */
+
+#include "oracle.h"
+#include "log.h"
+#include <queue>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+
+// Floyd-Warshall works on square tiles of this many vertices; two rows of
+// ints per tile line up with the SIMD width and a tile pair fits in L2.
+#define APSP_BLOCK 64
+
+size_t oracle_bytes(int n) {
+    return (size_t) n * n * (sizeof(int32_t) * 2);
+}
+
+static int32_t base_cost(const Graph &graph, const Edge &e) {
+    const Vertex &a = graph.vertices[e.start];
+    const Vertex &b = graph.vertices[e.end];
+    return abs(a.x - b.x) + abs(a.y - b.y);
+}
+
+// --------------------------------------------------------------------
+// Dijkstra from every source. Vertices are settled in distance order, so the
+// first hop of a vertex is known once its parent has been settled.
+static void build_dijkstra(const Graph &graph, DistanceOracle &o) {
+    int n = o.n;
+    #pragma omp parallel
+    {
+        std::vector<int> parent(n);
+        std::vector<int> order;
+        typedef std::pair<int32_t, int> Entry;
+
+        #pragma omp for schedule(dynamic, 16)
+        for (int s = 0; s < n; s++) {
+            int32_t *dist = &o.dist[(size_t) s * n];
+            int32_t *next = &o.next[(size_t) s * n];
+            std::fill(parent.begin(), parent.end(), -1);
+            order.clear();
+
+            std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> heap;
+            dist[s] = 0;
+            heap.push(Entry(0, s));
+            while (!heap.empty()) {
+                Entry top = heap.top();
+                heap.pop();
+                int u = top.second;
+                if (top.first > dist[u])
+                    continue;
+                order.push_back(u);
+                for (const Edge &e : graph.edges[u]) {
+                    int v = (e.start == u) ? e.end : e.start;
+                    int32_t d = top.first + base_cost(graph, e);
+                    if (d < dist[v]) {
+                        dist[v] = d;
+                        parent[v] = u;
+                        heap.push(Entry(d, v));
+                    }
+                }
+            }
+
+            next[s] = s;
+            for (size_t k = 1; k < order.size(); k++) {
+                int v = order[k];
+                next[v] = (parent[v] == s) ? v : next[parent[v]];
+            }
+        }
+    }
+}
+
+// --------------------------------------------------------------------
+// Blocked Floyd-Warshall on a matrix padded to whole tiles. Relaxes tile
+// (bi, bj) through the vertices of tile bk.
+static void relax_tile(int32_t *dist, int32_t *next, int N, int bi, int bj, int bk) {
+    int i0 = bi * APSP_BLOCK, j0 = bj * APSP_BLOCK, k0 = bk * APSP_BLOCK;
+    for (int k = k0; k < k0 + APSP_BLOCK; k++) {
+        const int32_t *dk = &dist[(size_t) k * N + j0];
+        for (int i = i0; i < i0 + APSP_BLOCK; i++) {
+            int32_t dik = dist[(size_t) i * N + k];
+            if (dik >= ORACLE_INF)
+                continue;
+            int32_t nik = next[(size_t) i * N + k];
+            int32_t *di = &dist[(size_t) i * N + j0];
+            int32_t *ni = &next[(size_t) i * N + j0];
+            #pragma omp simd
+            for (int j = 0; j < APSP_BLOCK; j++) {
+                int32_t d = dik + dk[j];
+                bool better = d < di[j];
+                di[j] = better ? d : di[j];
+                ni[j] = better ? nik : ni[j];
+            }
+        }
+    }
+}
+
+static void build_floyd(const Graph &graph, DistanceOracle &o) {
+    int n = o.n;
+    int tiles = (n + APSP_BLOCK - 1) / APSP_BLOCK;
+    int N = tiles * APSP_BLOCK;
+    std::vector<int32_t> dist((size_t) N * N, ORACLE_INF);
+    std::vector<int32_t> next((size_t) N * N, -1);
+    for (int u = 0; u < n; u++) {
+        dist[(size_t) u * N + u] = 0;
+        next[(size_t) u * N + u] = u;
+        for (const Edge &e : graph.edges[u]) {
+            int v = (e.start == u) ? e.end : e.start;
+            int32_t c = base_cost(graph, e);
+            if (c < dist[(size_t) u * N + v]) {
+                dist[(size_t) u * N + v] = c;
+                next[(size_t) u * N + v] = v;
+            }
+        }
+    }
+
+    for (int bk = 0; bk < tiles; bk++) {
+        // The pivot tile, then its row and column, then everything else.
+        relax_tile(dist.data(), next.data(), N, bk, bk, bk);
+        #pragma omp parallel for schedule(dynamic)
+        for (int b = 0; b < tiles; b++) {
+            if (b == bk)
+                continue;
+            relax_tile(dist.data(), next.data(), N, bk, b, bk);
+            relax_tile(dist.data(), next.data(), N, b, bk, bk);
+        }
+        #pragma omp parallel for collapse(2) schedule(dynamic)
+        for (int bi = 0; bi < tiles; bi++) {
+            for (int bj = 0; bj < tiles; bj++) {
+                if (bi != bk && bj != bk)
+                    relax_tile(dist.data(), next.data(), N, bi, bj, bk);
+            }
+        }
+    }
+
+    for (int u = 0; u < n; u++) {
+        std::copy(&dist[(size_t) u * N], &dist[(size_t) u * N] + n, &o.dist[(size_t) u * n]);
+        std::copy(&next[(size_t) u * N], &next[(size_t) u * N] + n, &o.next[(size_t) u * n]);
+    }
+}
+
+void build_distance_oracle(const Graph &graph, DistanceOracle &oracle, ApspMethod method) {
+    auto start = std::chrono::steady_clock::now();
+    int n = graph.vertices.size();
+    oracle.n = n;
+    oracle.dist.assign((size_t) n * n, ORACLE_INF);
+    oracle.next.assign((size_t) n * n, -1);
+
+    if (method == APSP_AUTO) {
+        // Dijkstra is O(V E log V) against Floyd-Warshall's O(V^3); the
+        // vectorized tiles make up for roughly a factor of 16.
+        size_t edges = 0;
+        for (const auto &list : graph.edges)
+            edges += list.size();
+        method = (edges * 16 < (size_t) n * n / 16) ? APSP_DIJKSTRA : APSP_FLOYD;
+    }
+    if (method == APSP_DIJKSTRA)
+        build_dijkstra(graph, oracle);
+    else
+        build_floyd(graph, oracle);
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    LOG_INFO("Built " << (method == APSP_DIJKSTRA ? "Dijkstra" : "Floyd-Warshall")
+             << " distance oracle for " << n << " vertices ("
+             << (unsigned long) (oracle_bytes(n) >> 20) << " MB) in " << elapsed.count() << "s");
+}
+
+bool oracle_route(const DistanceOracle &oracle, int start, int goal, std::vector<int> &path) {
+    size_t row = (size_t) oracle.n;
+    if (oracle.next[start * row + goal] < 0)
+        return false;
+    path.clear();
+    path.push_back(start);
+    for (int cur = start; cur != goal; ) {
+        cur = oracle.next[cur * row + goal];
+        path.push_back(cur);
+    }
+    return true;
+}
+
+bool parse_apsp_method(const std::string &name, ApspMethod &method) {
+    if (name == "auto")
+        method = APSP_AUTO;
+    else if (name == "floyd")
+        method = APSP_FLOYD;
+    else if (name == "dijkstra")
+        method = APSP_DIJKSTRA;
+    else
+        return false;
+    return true;
+}
+
+bool select_router(const Graph &graph, const SimOptions &opts, DistanceOracle &oracle) {
+    if (opts.router != "apsp" && opts.router != "auto")
+        return false;
+    size_t bytes = oracle_bytes(graph.vertices.size());
+    size_t budget = (size_t) opts.router_budget_mb << 20;
+    if (opts.router == "auto" && bytes > budget) {
+        LOG_INFO("Distance oracle needs " << (unsigned long) (bytes >> 20) << " MB, over the "
+                 << opts.router_budget_mb << " MB budget; routing with A*");
+        return false;
+    }
+    ApspMethod method = APSP_AUTO;
+    parse_apsp_method(opts.apsp_method, method);
+    build_distance_oracle(graph, oracle, method);
+    return true;
+}
@@ -0,0 +1,98 @@
+/**
+ *          15-418 Final Project
+ *          Title:  Congestion Aware Map Routing
+ *          Credit: Parth Iyer   (pniyer@andrew.cmu.edu)
+ *                  Kwaku Baryeh (kbaryeh@andrew.cmu.edu)
+ */
+
+#ifndef ORACLE_H
+#define ORACLE_H
+
+#include "graph.h"
+#include "options.h"
+#include <vector>
+#include <string>
+#include <stdint.h>
+#include <cstddef>
+
+/**
+ * @name                ApspMethod
+ * @details             How the all-pairs table is computed.
+ *
+ * APSP_AUTO            Dijkstra from every vertex on sparse graphs, otherwise
+ *                      Floyd-Warshall
+ * APSP_FLOYD           Cache blocked Floyd-Warshall, O(V^3)
+ * APSP_DIJKSTRA        One Dijkstra per source vertex, O(V E log V)
+ */
+enum ApspMethod {
+    APSP_AUTO,
+    APSP_FLOYD,
+    APSP_DIJKSTRA
+};
+
+/**
+ * @name                DistanceOracle
+ * @details             All-pairs shortest base-cost (Manhattan) distances and
+ *                      next hops, stored row-major: entry u * n + v belongs to
+ *                      the pair (u, v). Unreachable pairs have dist ORACLE_INF
+ *                      and next -1.
+ *
+ * @param n             The number of vertices
+ * @param dist          Shortest distance from u to v
+ * @param next          The vertex after u on a shortest path from u to v
+ */
+struct DistanceOracle {
+    int n;
+    std::vector<int32_t> dist;
+    std::vector<int32_t> next;
+};
+
+const int32_t ORACLE_INF = 1 << 29;
+
+/**
+ * @name                oracle_bytes
+ * @return              The memory the oracle of an n vertex graph needs
+ */
+size_t oracle_bytes(int n);
+
+/**
+ * @name                build_distance_oracle
+ * @details             Fills the distance and next hop tables, using every
+ *                      OpenMP thread.
+ *
+ * @param[in] method    The algorithm; APSP_AUTO picks by density
+ */
+void build_distance_oracle(const Graph &graph, DistanceOracle &oracle, ApspMethod method);
+
+/**
+ * @name                oracle_route
+ * @details             Walks the next hop table from start to goal. A drop-in
+ *                      replacement for a_star with static edge costs, although
+ *                      ties between equally short routes may break differently.
+ *
+ * @param[out] path     The route, including start and goal
+ * @return              false if goal is unreachable
+ */
+bool oracle_route(const DistanceOracle &oracle, int start, int goal, std::vector<int> &path);
+
+/**
+ * @name                parse_apsp_method
+ * @details             Parses auto, floyd or dijkstra.
+ *
+ * @return              false if the name is unknown
+ */
+bool parse_apsp_method(const std::string &name, ApspMethod &method);
+
+/**
+ * @name                select_router
+ * @details             Decides between per-query A* and the oracle from
+ *                      opts.router ("astar", "apsp" or "auto", which uses the
+ *                      oracle when it fits in opts.router_budget_mb) and
+ *                      builds the oracle if it is chosen. Other routers never
+ *                      use the oracle.
+ *
+ * @return              true if the oracle was built and should be used
+ */
+bool select_router(const Graph &graph, const SimOptions &opts, DistanceOracle &oracle);
+
+#endif // ORACLE_H
@@ -0,0 +1,363 @@
+/**
+ *          15-418 Final Project
+ *          Title:  Congestion Aware Map Routing
+ *          Credit: Parth Iyer   (pniyer@andrew.cmu.edu)
+ *                  Kwaku Baryeh (kbaryeh@andrew.cmu.edu)
+ */
+
+#include "overlay.h"
+#include "partition.h"
+#include "astar.h"
+#include "log.h"
+#include <algorithm>
+#include <functional>
+#include <chrono>
+
+// Each level's cells hold 2^OVERLAY_FANOUT_BITS cells of the level below.
+#define OVERLAY_FANOUT_BITS 4
+
+static int other_end(const Edge &e, int u) {
+    return (e.start == u) ? e.end : e.start;
+}
+
+// --------------------------------------------------------------------
+// Dijkstra scratch space, one per thread. `via` is the level of the clique
+// arc a vertex was reached by, or 0 for an edge of the graph.
+struct OverlayScratch {
+    std::vector<int> dist;
+    std::vector<int> parent;
+    std::vector<int> via;
+    std::vector<uint32_t> seen;
+    uint32_t epoch;
+    std::vector<std::pair<int, int>> heap;
+    const Vertex *target;
+    const Vertex *vertices;
+
+    OverlayScratch() : epoch(0), target(NULL), vertices(NULL) {}
+
+    void begin(int n) {
+        if ((int) seen.size() < n) {
+            dist.resize(n);
+            parent.resize(n);
+            via.resize(n);
+            seen.resize(n, 0);
+        }
+        if (++epoch == 0) {
+            std::fill(seen.begin(), seen.end(), 0);
+            epoch = 1;
+        }
+        heap.clear();
+    }
+    bool reached(int v) const {
+        return seen[v] == epoch;
+    }
+    int potential(int v) const {
+        if (target == NULL)
+            return 0;
+        return abs(vertices[v].x - target->x) + abs(vertices[v].y - target->y);
+    }
+    void relax(int u, int v, int w, int level) {
+        int d = dist[u] + w;
+        if (!reached(v) || d < dist[v]) {
+            seen[v] = epoch;
+            dist[v] = d;
+            parent[v] = u;
+            via[v] = level;
+            heap.push_back(std::make_pair(-(d + potential(v)), v));
+            std::push_heap(heap.begin(), heap.end());
+        }
+    }
+};
+
+// Accessing a thread_local with a constructor goes through a wrapper call, so
+// it is looked up once per query and passed down.
+static thread_local OverlayScratch thread_scratch;
+
+// Runs Dijkstra from src until goal (or everything reachable, for goal -1) is
+// settled. expand(u) relaxes the arcs leaving u. With a goal the search is an
+// A* on the Manhattan distance to it, a consistent lower bound for edge_cost
+// since every edge costs at least its own Manhattan length.
+template <class Expand>
+static void dijkstra(OverlayScratch &s, const Graph &graph, int src, int goal, Expand expand) {
+    s.begin(graph.vertices.size());
+    s.target = goal >= 0 ? &graph.vertices[goal] : NULL;
+    s.vertices = graph.vertices.data();
+    s.seen[src] = s.epoch;
+    s.dist[src] = 0;
+    s.parent[src] = -1;
+    s.via[src] = 0;
+    s.heap.push_back(std::make_pair(0, src));
+    while (!s.heap.empty()) {
+        std::pop_heap(s.heap.begin(), s.heap.end());
+        std::pair<int, int> top = s.heap.back();
+        s.heap.pop_back();
+        int u = top.second;
+        if (-top.first > s.dist[u] + s.potential(u))
+            continue;
+        if (u == goal)
+            return;
+        expand(u);
+    }
+}
+
+// The clique arcs leaving u within its cell on `level` (1-based).
+static void relax_clique(OverlayScratch &s, const OverlayGraph &o, int level, int u) {
+    const OverlayLevel &L = o.levels[level - 1];
+    int c = L.cell[u];
+    int row = L.boundary_index[u];
+    int b = L.boundary_start[c + 1] - L.boundary_start[c];
+    const int32_t *weights = &L.clique[L.clique_start[c] + (size_t) row * b];
+    const int *members = &L.boundary[L.boundary_start[c]];
+    for (int k = 0; k < b; k++) {
+        if (weights[k] < OVERLAY_INF && members[k] != u)
+            s.relax(u, members[k], weights[k], level);
+    }
+}
+
+// --------------------------------------------------------------------
+// Searches inside cell c of `level` on the level below it: the graph itself
+// for level 1, otherwise the cliques of the subcells and the edges between
+// them.
+static void cell_search(OverlayScratch &s, const Graph &graph, const OverlayGraph &o,
+                        int level, int c, int src, int goal) {
+    const OverlayLevel &L = o.levels[level - 1];
+    if (level == 1) {
+        dijkstra(s, graph, src, goal, [&](int u) {
+            for (const Edge &e : graph.edges[u]) {
+                int v = other_end(e, u);
+                if (L.cell[v] == c && edge_open(e))
+                    s.relax(u, v, edge_cost(graph, e), 0);
+            }
+        });
+        return;
+    }
+    const OverlayLevel &sub = o.levels[level - 2];
+    dijkstra(s, graph, src, goal, [&](int u) {
+        relax_clique(s, o, level - 1, u);
+        for (const Edge &e : graph.edges[u]) {
+            int v = other_end(e, u);
+            if (sub.cell[v] != sub.cell[u] && L.cell[v] == c && edge_open(e))
+                s.relax(u, v, edge_cost(graph, e), 0);
+        }
+    });
+}
+
+// The vertices and arc levels from the search source to v, in order.
+static void trace_back(const OverlayScratch &s, int v, std::vector<std::pair<int, int>> &hops) {
+    hops.clear();
+    for (int cur = v; cur != -1; cur = s.parent[cur])
+        hops.push_back(std::make_pair(cur, s.via[cur]));
+    std::reverse(hops.begin(), hops.end());
+}
+
+// Appends the vertices after `from` of the path a hop list describes, expanding
+// clique arcs into the routes inside their cells.
+static void unpack(OverlayScratch &s, const Graph &graph, const OverlayGraph &o,
+                   const std::vector<std::pair<int, int>> &hops, std::vector<int> &path) {
+    for (size_t k = 1; k < hops.size(); k++) {
+        int level = hops[k].second;
+        if (level == 0) {
+            path.push_back(hops[k].first);
+            continue;
+        }
+        int a = hops[k - 1].first, b = hops[k].first;
+        cell_search(s, graph, o, level, o.levels[level - 1].cell[a], a, b);
+        std::vector<std::pair<int, int>> inner;
+        trace_back(s, b, inner);
+        unpack(s, graph, o, inner, path);
+    }
+}
+
+// --------------------------------------------------------------------
+void build_overlay(const Graph &graph, OverlayGraph &overlay, int cellSize, int levels) {
+    int n = graph.vertices.size();
+    overlay.levels.clear();
+    overlay.raised.clear();
+    int parts = 2;
+    while ((long) parts * std::max(cellSize, 1) < n)
+        parts *= 2;
+    // Coordinate bisection into a power of two parts numbers the regions by
+    // their bisection path, so dropping low bits gives the coarser levels.
+    std::vector<int> region = partition_by_coordinates(graph, parts);
+
+    for (int li = 0; li < levels; li++) {
+        int shift = li * OVERLAY_FANOUT_BITS;
+        if ((parts >> shift) < 2)
+            break;
+        overlay.levels.push_back(OverlayLevel());
+        OverlayLevel &L = overlay.levels.back();
+        L.cells = parts >> shift;
+        L.cell.resize(n);
+        for (int v = 0; v < n; v++)
+            L.cell[v] = region[v] >> shift;
+
+        // A vertex is on the boundary if an edge joins it to another cell,
+        // in either direction.
+        std::vector<char> onBoundary(n, 0);
+        for (int u = 0; u < n; u++) {
+            for (const Edge &e : graph.edges[u]) {
+                int v = other_end(e, u);
+                if (L.cell[u] != L.cell[v])
+                    onBoundary[u] = onBoundary[v] = 1;
+            }
+        }
+        L.boundary_start.assign(L.cells + 1, 0);
+        for (int v = 0; v < n; v++)
+            L.boundary_start[L.cell[v] + 1] += onBoundary[v];
+        for (int c = 0; c < L.cells; c++)
+            L.boundary_start[c + 1] += L.boundary_start[c];
+        L.boundary.resize(L.boundary_start[L.cells]);
+        L.boundary_index.assign(n, -1);
+        std::vector<int> fill(L.boundary_start.begin(), L.boundary_start.end() - 1);
+        for (int v = 0; v < n; v++) {
+            if (onBoundary[v]) {
+                int c = L.cell[v];
+                L.boundary_index[v] = fill[c] - L.boundary_start[c];
+                L.boundary[fill[c]++] = v;
+            }
+        }
+
+        L.clique_start.resize(L.cells + 1);
+        L.clique_start[0] = 0;
+        for (int c = 0; c < L.cells; c++) {
+            size_t b = L.boundary_start[c + 1] - L.boundary_start[c];
+            L.clique_start[c + 1] = L.clique_start[c] + b * b;
+        }
+        L.clique.assign(L.clique_start[L.cells], OVERLAY_INF);
+        L.dirty.assign(L.cells, 1);
+    }
+}
+
+int customize_overlay(const Graph &graph, OverlayGraph &overlay, bool all) {
+    int total = 0;
+    for (int li = 0; li < (int) overlay.levels.size(); li++) {
+        OverlayLevel &L = overlay.levels[li];
+        std::vector<int> cells;
+        for (int c = 0; c < L.cells; c++) {
+            if (all || L.dirty[c])
+                cells.push_back(c);
+            L.dirty[c] = 0;
+        }
+        total += cells.size();
+
+        // Cells of one level only read the level below, so they are independent.
+        #pragma omp parallel for schedule(dynamic)
+        for (int k = 0; k < (int) cells.size(); k++) {
+            OverlayScratch &s = thread_scratch;
+            int c = cells[k];
+            int first = L.boundary_start[c];
+            int b = L.boundary_start[c + 1] - first;
+            for (int r = 0; r < b; r++) {
+                cell_search(s, graph, overlay, li + 1, c, L.boundary[first + r], -1);
+                int32_t *row = &L.clique[L.clique_start[c] + (size_t) r * b];
+                for (int k2 = 0; k2 < b; k2++) {
+                    int v = L.boundary[first + k2];
+                    row[k2] = s.reached(v) ? s.dist[v] : OVERLAY_INF;
+                }
+            }
+        }
+    }
+    return total;
+}
+
+// Marks the cells whose cliques can use the edge: those which contain both
+// of its ends, on every level.
+static void mark_edge(const Graph &graph, OverlayGraph &overlay, const EdgeRef &ref) {
+    int u = ref.vertex;
+    int v = other_end(graph.edges[u][ref.local], u);
+    for (OverlayLevel &L : overlay.levels) {
+        if (L.cell[u] == L.cell[v])
+            L.dirty[L.cell[u]] = 1;
+    }
+}
+
+int customize_overlay_loads(const Graph &graph, OverlayGraph &overlay,
+                            const std::vector<EdgeRef> &loaded) {
+    // Only edges whose cost differs from their length matter: those raised
+    // at the last call, which may have dropped back, and those raised now.
+    for (const EdgeRef &e : overlay.raised)
+        mark_edge(graph, overlay, e);
+    overlay.raised.clear();
+    for (const EdgeRef &e : loaded) {
+        const Edge &edge = graph.edges[e.vertex][e.local];
+        const Vertex &a = graph.vertices[edge.start];
+        const Vertex &b = graph.vertices[edge.end];
+        if (edge_cost(graph, edge) != abs(a.x - b.x) + abs(a.y - b.y)) {
+            mark_edge(graph, overlay, e);
+            overlay.raised.push_back(e);
+        }
+    }
+    return customize_overlay(graph, overlay, false);
+}
+
+int customize_overlay_edges(const Graph &graph, OverlayGraph &overlay,
+                            const std::vector<EdgeRef> &changed) {
+    for (const EdgeRef &e : changed)
+        mark_edge(graph, overlay, e);
+    return customize_overlay(graph, overlay, false);
+}
+
+// --------------------------------------------------------------------
+bool overlay_route(const Graph &graph, const OverlayGraph &o, int start, int goal,
+                   std::vector<int> &path) {
+    int top = o.levels.size();
+    // The coarsest level on which u shares a cell with neither end, or 0.
+    auto query_level = [&](int u) {
+        for (int l = top; l >= 1; l--) {
+            const std::vector<int> &cell = o.levels[l - 1].cell;
+            if (cell[u] != cell[start] && cell[u] != cell[goal])
+                return l;
+        }
+        return 0;
+    };
+
+    OverlayScratch &s = thread_scratch;
+    dijkstra(s, graph, start, goal, [&](int u) {
+        int l = query_level(u);
+        if (l > 0 && o.levels[l - 1].boundary_index[u] >= 0) {
+            const std::vector<int> &cell = o.levels[l - 1].cell;
+            relax_clique(s, o, l, u);
+            for (const Edge &e : graph.edges[u]) {
+                int v = other_end(e, u);
+                if (cell[v] != cell[u] && edge_open(e))
+                    s.relax(u, v, edge_cost(graph, e), 0);
+            }
+        } else {
+            for (const Edge &e : graph.edges[u]) {
+                if (edge_open(e))
+                    s.relax(u, other_end(e, u), edge_cost(graph, e), 0);
+            }
+        }
+    });
+    if (!s.reached(goal))
+        return false;
+
+    std::vector<std::pair<int, int>> hops;
+    trace_back(s, goal, hops);
+    path.clear();
+    path.push_back(start);
+    unpack(s, graph, o, hops, path);
+    LOG_TRACE("[overlay] Found route: " << path);
+    return true;
+}
+
+bool select_overlay(const Graph &graph, const SimOptions &opts, OverlayGraph &overlay) {
+    if (opts.router != "overlay")
+        return false;
+    auto start = std::chrono::steady_clock::now();
+    build_overlay(graph, overlay, opts.overlay_cell, opts.overlay_levels);
+    auto built = std::chrono::steady_clock::now();
+    customize_overlay(graph, overlay, true);
+    auto done = std::chrono::steady_clock::now();
+
+    std::chrono::duration<double> buildTime = built - start, customizeTime = done - built;
+    LOG_INFO("Built a " << (int) overlay.levels.size() << " level overlay in " << buildTime.count()
+             << "s, customized in " << customizeTime.count() << "s");
+    for (size_t li = 0; li < overlay.levels.size(); li++) {
+        const OverlayLevel &L = overlay.levels[li];
+        LOG_INFO("  level " << (int) li + 1 << ": " << L.cells << " cells, "
+                 << (int) L.boundary.size() << " boundary vertices, "
+                 << (unsigned long) L.clique.size() << " clique entries");
+    }
+    return true;
+}
@@ -0,0 +1,141 @@
+/**
+ *          15-418 Final Project
+ *          Title:  Congestion Aware Map Routing
+ *          Credit: Parth Iyer   (pniyer@andrew.cmu.edu)
+ *                  Kwaku Baryeh (kbaryeh@andrew.cmu.edu)
+ */
+
+#ifndef OVERLAY_H
+#define OVERLAY_H
+
+#include "graph.h"
+#include "options.h"
+#include "vehicles.h"
+#include <vector>
+#include <stdint.h>
+#include <cstddef>
+
+/**
+ * A multi-level overlay in the style of customizable route planning (CRP).
+ * The vertices are split into nested cells by coordinate bisection. A vertex
+ * with an edge leaving its cell is a boundary vertex of that level, and every
+ * cell stores the shortest distances between its boundary vertices (a clique).
+ *
+ * Building the cells depends only on the topology. The cliques depend on
+ * edge_cost and are filled in by the customization, which works bottom up and
+ * in parallel over the cells of a level, and can be redone for just the cells
+ * whose edges changed load.
+ */
+
+/**
+ * @name                OverlayLevel
+ * @details             The cells of one level and their cliques.
+ *
+ * @param cell          The cell of every vertex
+ * @param cells         The number of cells
+ * @param boundary_index  A vertex's index among its cell's boundary vertices,
+ *                      or -1 if it is not one
+ * @param boundary_start  Boundary vertices of cell c are boundary[boundary_start[c]]
+ *                      up to boundary[boundary_start[c + 1]]
+ * @param boundary      Boundary vertices, grouped by cell
+ * @param clique_start  Offset of cell c's clique in `clique`
+ * @param clique        Row-major b x b distance matrices, one per cell;
+ *                      OVERLAY_INF if there is no path within the cell
+ * @param dirty         Cells whose clique must be recomputed
+ */
+struct OverlayLevel {
+    std::vector<int> cell;
+    int cells;
+    std::vector<int> boundary_index;
+    std::vector<int> boundary_start;
+    std::vector<int> boundary;
+    std::vector<size_t> clique_start;
+    std::vector<int32_t> clique;
+    std::vector<char> dirty;
+};
+
+/**
+ * @name                OverlayGraph
+ * @details             The levels of the overlay, finest first: levels[0] is
+ *                      level 1, whose cells are made of graph vertices.
+ *
+ * @param levels        The overlay levels
+ * @param raised        Edges which cost more than their length at the last
+ *                      customization
+ */
+struct OverlayGraph {
+    std::vector<OverlayLevel> levels;
+    std::vector<EdgeRef> raised;
+};
+
+const int32_t OVERLAY_INF = 1 << 29;
+
+/**
+ * @name                build_overlay
+ * @details             Partitions the graph into cells of about `cellSize`
+ *                      vertices, with 16 times as many vertices per cell on
+ *                      each level above, and finds the boundary vertices. Levels
+ *                      of a single cell are left out. Call customize_overlay
+ *                      before routing.
+ *
+ * @param[in] levels    The most levels to build
+ */
+void build_overlay(const Graph &graph, OverlayGraph &overlay, int cellSize, int levels);
+
+/**
+ * @name                customize_overlay
+ * @details             Recomputes the cliques of every cell marked dirty, level
+ *                      by level, with all OpenMP threads.
+ *
+ * @param[in] all       Mark every cell dirty first
+ * @return              The number of cells recomputed
+ */
+int customize_overlay(const Graph &graph, OverlayGraph &overlay, bool all);
+
+/**
+ * @name                customize_overlay_loads
+ * @details             Marks the cells holding an edge whose cost changed since
+ *                      the last call and recustomizes them. Only edges in
+ *                      `loaded` can cost more than their length. Call after
+ *                      update_edge_loads_current.
+ *
+ * @return              The number of cells recomputed
+ */
+int customize_overlay_loads(const Graph &graph, OverlayGraph &overlay,
+                            const std::vector<EdgeRef> &loaded);
+
+/**
+ * @name                customize_overlay_edges
+ * @details             Recustomizes the cells holding an edge which was closed,
+ *                      reopened or changed capacity, so the cost is that of the
+ *                      cells around the changed edges.
+ *
+ * @return              The number of cells recomputed
+ */
+int customize_overlay_edges(const Graph &graph, OverlayGraph &overlay,
+                            const std::vector<EdgeRef> &changed);
+
+/**
+ * @name                overlay_route
+ * @details             Shortest route under edge_cost from start to goal. The
+ *                      search runs on the coarsest level that does not contain
+ *                      start or goal, and the shortcuts it takes are expanded
+ *                      by searches inside their cells. Safe to call from
+ *                      several threads while the overlay is not customized.
+ *
+ * @param[out] path     The route, including start and goal
+ * @return              false if goal is unreachable
+ */
+bool overlay_route(const Graph &graph, const OverlayGraph &overlay, int start, int goal,
+                   std::vector<int> &path);
+
+/**
+ * @name                select_overlay
+ * @details             Builds and customizes the overlay if opts.router is
+ *                      "overlay".
+ *
+ * @return              true if the overlay was built and should be used
+ */
+bool select_overlay(const Graph &graph, const SimOptions &opts, OverlayGraph &overlay);
+
+#endif // OVERLAY_H
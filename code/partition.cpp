@@ -0,0 +1,58 @@
+/**
+ *          15-418 Final Project
+ *          Title:  Congestion Aware Map Routing
+ *          Credit: Parth Iyer   (pniyer@andrew.cmu.edu)
+ *                  Kwaku Baryeh (kbaryeh@andrew.cmu.edu)
+ */
+
+#include "partition.h"
+#include <algorithm>
+
+static void bisect(const Graph &graph, std::vector<int>::iterator begin, std::vector<int>::iterator end,
+                   int first, int parts, std::vector<int> &region) {
+    if (parts <= 1 || end - begin <= 1) {
+        for (auto it = begin; it != end; ++it)
+            region[*it] = first;
+        return;
+    }
+
+    // Split along the longer side of the bounding box.
+    int minX = graph.vertices[*begin].x, maxX = minX;
+    int minY = graph.vertices[*begin].y, maxY = minY;
+    for (auto it = begin; it != end; ++it) {
+        const Vertex &v = graph.vertices[*it];
+        minX = std::min(minX, v.x); maxX = std::max(maxX, v.x);
+        minY = std::min(minY, v.y); maxY = std::max(maxY, v.y);
+    }
+    bool alongX = maxX - minX >= maxY - minY;
+
+    // Uneven part counts get a proportional share of the vertices.
+    int leftParts = parts / 2;
+    auto mid = begin + (end - begin) * leftParts / parts;
+    std::nth_element(begin, mid, end, [&](int a, int b) {
+        const Vertex &va = graph.vertices[a], &vb = graph.vertices[b];
+        return alongX ? (va.x < vb.x || (va.x == vb.x && va.y < vb.y))
+                      : (va.y < vb.y || (va.y == vb.y && va.x < vb.x));
+    });
+
+    bisect(graph, begin, mid, first, leftParts, region);
+    bisect(graph, mid, end, first + leftParts, parts - leftParts, region);
+}
+
+std::vector<int> partition_by_coordinates(const Graph &graph, int parts) {
+    int n = graph.vertices.size();
+    std::vector<int> order(n);
+    for (int i = 0; i < n; i++)
+        order[i] = i;
+    std::vector<int> region(n, 0);
+    bisect(graph, order.begin(), order.end(), 0, std::max(parts, 1), region);
+    return region;
+}
+
+long count_cut_edges(const Graph &graph, const std::vector<int> &region) {
+    long cut = 0;
+    for (const auto &list : graph.edges)
+        for (const Edge &e : list)
+            cut += region[e.start] != region[e.end];
+    return cut;
+}
@@ -0,0 +1,33 @@
+/**
+ *          15-418 Final Project
+ *          Title:  Congestion Aware Map Routing
+ *          Credit: Parth Iyer   (pniyer@andrew.cmu.edu)
+ *                  Kwaku Baryeh (kbaryeh@andrew.cmu.edu)
+ */
+
+#ifndef PARTITION_H
+#define PARTITION_H
+
+#include "graph.h"
+#include <vector>
+
+/**
+ * @name                partition_by_coordinates
+ * @details             Recursive coordinate bisection: splits the vertices at
+ *                      the median of their longer axis until there are `parts`
+ *                      regions of (almost) equal size. Region ids are assigned
+ *                      so that regions which are close in space have close ids.
+ *
+ * @param[in] graph     The graph whose vertices we are partitioning
+ * @param[in] parts     The number of regions
+ * @return              The region of every vertex
+ */
+std::vector<int> partition_by_coordinates(const Graph &graph, int parts);
+
+/**
+ * @name                count_cut_edges
+ * @details             Counts the edges whose endpoints are in different regions.
+ */
+long count_cut_edges(const Graph &graph, const std::vector<int> &region);
+
+#endif // PARTITION_H
@@ -1,43 +1,57 @@
+import csv, sys
 import matplotlib.pyplot as plt
 import numpy as np
 
-# Measured times in seconds.
-# These are the reported times for each difficulty level.
-sequential_times = {
-    'easy': 211.703,
-    'medium': 212.053,
-    'hard': 859.371
-}
+# Reads the CSV written by `./bench --csv bench.csv` and plots the end-to-end
+# times of each input and the speedup of the parallel engine over the
+# sequential one. Usage: python3 plot_speedup.py [bench.csv]
+results_file = sys.argv[1] if len(sys.argv) > 1 else 'bench.csv'
 
-parallel_times = {
-    'easy': 31.4985,
-    'medium': 32.5515,
-    'hard': 137.093
-}
+sequential_times = {}
+parallel_times = {}     # input -> {threads: median seconds}
+with open(results_file) as f:
+    for row in csv.DictReader(f):
+        if row['benchmark'] == 'sequential':
+            sequential_times[row['input']] = float(row['median_s'])
+        elif row['benchmark'] == 'parallel':
+            parallel_times.setdefault(row['input'], {})[int(row['threads'])] = float(row['median_s'])
 
-# sequential_time / parallel_time.
-difficulties = ['easy', 'medium', 'hard']
-speedups = [sequential_times[d] / parallel_times[d] for d in difficulties]
+inputs = [i for i in sequential_times if i in parallel_times]
+if not inputs:
+    sys.exit(f'No sequential and parallel results in {results_file}')
+
+# The parallel time of each input is the one with the most threads.
+best_parallel = {i: parallel_times[i][max(parallel_times[i])] for i in inputs}
+speedups = [sequential_times[i] / best_parallel[i] for i in inputs]
 
 # execution times.
-fig, axs = plt.subplots(2, 1, figsize=(8, 10))
-x = np.arange(len(difficulties))
+fig, axs = plt.subplots(3, 1, figsize=(8, 14))
+x = np.arange(len(inputs))
 
-axs[0].bar(x - 0.15, [sequential_times[d] for d in difficulties], width=0.3, label='Sequential', color='skyblue')
-axs[0].bar(x + 0.15, [parallel_times[d] for d in difficulties], width=0.3, label='Parallel', color='lightgreen')
+axs[0].bar(x - 0.15, [sequential_times[i] for i in inputs], width=0.3, label='Sequential', color='skyblue')
+axs[0].bar(x + 0.15, [best_parallel[i] for i in inputs], width=0.3, label='Parallel', color='lightgreen')
 axs[0].set_xticks(x)
-axs[0].set_xticklabels(difficulties)
+axs[0].set_xticklabels(inputs)
 axs[0].set_ylabel('Time (s)')
-axs[0].set_title('Execution Times')
+axs[0].set_title('Execution Times (median)')
 axs[0].legend()
 
 # Speedup.
 axs[1].bar(x, speedups, color='coral')
 axs[1].set_xticks(x)
-axs[1].set_xticklabels(difficulties)
+axs[1].set_xticklabels(inputs)
 axs[1].set_ylabel('Speedup Factor')
 axs[1].set_title('Sequential vs. Parallel Speedup')
 
+# Scaling with the number of threads.
+for i in inputs:
+    threads = sorted(parallel_times[i])
+    axs[2].plot(threads, [sequential_times[i] / parallel_times[i][t] for t in threads], marker='o', label=i)
+axs[2].set_xlabel('Threads')
+axs[2].set_ylabel('Speedup Factor')
+axs[2].set_title('Parallel Scaling')
+axs[2].legend()
+
 plt.tight_layout()
 plt.savefig("speedup_graph.png")
 plt.show()
@@ -0,0 +1,240 @@
+/**
+ *          15-418 Final Project
+ *          Title:  Congestion Aware Map Routing
+ *          Credit: Parth Iyer   (pniyer@andrew.cmu.edu)
+ *                  Kwaku Baryeh (kbaryeh@andrew.cmu.edu)
+ */
+
+#include "graph.h"
+#include <vector>
+#include <deque>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <errno.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/**
+ * Load generator for route_server. Each client connects to the server's
+ * socket and keeps `pipeline` requests in flight: random ROUTE queries between
+ * vertices of the problem, and with --updates P a LOAD of a random edge for
+ * P percent of the requests. The latency of a request runs from when it was
+ * written to when its reply was read.
+ *
+ * `./route_loadgen <problem_file> <socket> [--clients C] [--queries N]
+ *      [--pipeline D] [--updates P] [--seed S] [--shutdown]`
+ */
+
+typedef std::chrono::steady_clock Clock;
+
+struct ClientResult {
+    std::vector<double> latency_us;
+    unsigned long routes, updates, none, errors;
+    bool ok;
+};
+
+static int connect_to(const char *path) {
+    struct sockaddr_un addr;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Socket path %s is too long\n", path);
+        return -1;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        fprintf(stderr, "socket failed: %s\n", strerror(errno));
+        return -1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    if (connect(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0) {
+        fprintf(stderr, "Cannot connect to %s: %s\n", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static bool write_all(int fd, const std::string &data) {
+    size_t done = 0;
+    while (done < data.size()) {
+        ssize_t n = write(fd, data.data() + done, data.size() - done);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        done += n;
+    }
+    return true;
+}
+
+// Reads one reply line into `line`, buffering whatever follows it.
+static bool read_line(int fd, std::string &buffer, std::string &line) {
+    size_t end;
+    while ((end = buffer.find('\n')) == std::string::npos) {
+        char chunk[65536];
+        ssize_t n = read(fd, chunk, sizeof(chunk));
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        buffer.append(chunk, n);
+    }
+    line = buffer.substr(0, end);
+    buffer.erase(0, end + 1);
+    return true;
+}
+
+static std::string make_request(const Graph &graph, int updates, unsigned int &seed, bool &isLoad) {
+    int n = graph.vertices.size();
+    isLoad = (int) (rand_r(&seed) % 100) < updates;
+    if (isLoad) {
+        // A vertex with outgoing edges always exists in a valid problem.
+        int u;
+        do {
+            u = rand_r(&seed) % n;
+        } while (graph.edges[u].empty());
+        const Edge &e = graph.edges[u][rand_r(&seed) % graph.edges[u].size()];
+        return "LOAD " + std::to_string(e.start) + " " + std::to_string(e.end) + " " +
+               std::to_string(rand_r(&seed) % (2 * e.capacity + 1)) + "\n";
+    }
+    return "ROUTE " + std::to_string(rand_r(&seed) % n) + " " + std::to_string(rand_r(&seed) % n) + "\n";
+}
+
+static void run_client(const Graph &graph, const char *path, int queries, int pipeline, int updates,
+                       unsigned int seed, ClientResult &result) {
+    result.routes = result.updates = result.none = result.errors = 0;
+    result.ok = false;
+    int fd = connect_to(path);
+    if (fd < 0)
+        return;
+    result.latency_us.reserve(queries);
+    std::deque<Clock::time_point> sent;
+    std::string buffer, line;
+    int issued = 0;
+    while ((int) result.latency_us.size() < queries) {
+        // Top the pipeline up, then wait for the oldest reply.
+        std::string out;
+        while (issued < queries && (int) sent.size() < pipeline) {
+            bool isLoad;
+            out += make_request(graph, updates, seed, isLoad);
+            if (isLoad)
+                result.updates++;
+            else
+                result.routes++;
+            sent.push_back(Clock::now());
+            issued++;
+        }
+        if (!out.empty() && !write_all(fd, out)) {
+            fprintf(stderr, "Server hung up\n");
+            close(fd);
+            return;
+        }
+        if (!read_line(fd, buffer, line)) {
+            fprintf(stderr, "Server hung up\n");
+            close(fd);
+            return;
+        }
+        std::chrono::duration<double, std::micro> latency = Clock::now() - sent.front();
+        sent.pop_front();
+        result.latency_us.push_back(latency.count());
+        if (line.compare(0, 4, "NONE") == 0)
+            result.none++;
+        else if (line.compare(0, 2, "OK") != 0)
+            result.errors++;
+    }
+    close(fd);
+    result.ok = true;
+}
+
+static double percentile(const std::vector<double> &sorted, double q) {
+    if (sorted.empty())
+        return 0;
+    size_t k = std::min(sorted.size() - 1, (size_t) (q * (sorted.size() - 1) + 0.5));
+    return sorted[k];
+}
+
+int main(int argc, char *argv[]) {
+    std::vector<std::string> positional;
+    int clients = 4, queries = 10000, pipeline = 8, updates = 0;
+    unsigned int seed = 1;
+    bool shutdown = false;
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--clients") == 0 && hasValue) {
+            clients = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--queries") == 0 && hasValue) {
+            queries = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--pipeline") == 0 && hasValue) {
+            pipeline = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--updates") == 0 && hasValue) {
+            updates = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && hasValue) {
+            seed = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--shutdown") == 0) {
+            shutdown = true;
+        } else {
+            positional.push_back(argv[i]);
+        }
+    }
+    if (positional.size() != 2 || clients < 1 || queries < 1 || pipeline < 1 || updates < 0 || updates > 100) {
+        fprintf(stderr, "Usage: %s <problem_file> <socket> [--clients C] [--queries N] "
+                "[--pipeline D] [--updates P] [--seed S] [--shutdown]\n", argv[0]);
+        return 1;
+    }
+    Problem p = load_problem(positional[0]);
+    if (p.graph.vertices.empty() || p.graph.num_edges == 0) {
+        fprintf(stderr, "Need a problem with at least one edge!\n");
+        return 1;
+    }
+    const char *path = positional[1].c_str();
+
+    // Each client sends queries / clients requests.
+    std::vector<ClientResult> results(clients);
+    std::vector<std::thread> threads;
+    auto start = Clock::now();
+    for (int c = 0; c < clients; c++) {
+        int share = queries / clients + (c < queries % clients ? 1 : 0);
+        threads.emplace_back(run_client, std::cref(p.graph), path, std::max(share, 1), pipeline, updates,
+                             seed * 7919u + c, std::ref(results[c]));
+    }
+    for (std::thread &t : threads)
+        t.join();
+    std::chrono::duration<double> wall = Clock::now() - start;
+
+    std::vector<double> latency;
+    unsigned long routes = 0, loads = 0, none = 0, errors = 0;
+    int failed = 0;
+    for (ClientResult &r : results) {
+        latency.insert(latency.end(), r.latency_us.begin(), r.latency_us.end());
+        routes += r.routes;
+        loads += r.updates;
+        none += r.none;
+        errors += r.errors;
+        failed += !r.ok;
+    }
+    std::sort(latency.begin(), latency.end());
+
+    if (shutdown) {
+        int fd = connect_to(path);
+        std::string buffer, line;
+        if (fd < 0 || !write_all(fd, "SHUTDOWN\n") || !read_line(fd, buffer, line))
+            failed++;
+        if (fd >= 0)
+            close(fd);
+    }
+
+    printf("%lu requests (%lu routes, %lu load updates) from %d clients, %d in flight each, in %.3f seconds\n",
+           (unsigned long) latency.size(), routes, loads, clients, pipeline, wall.count());
+    printf("Throughput: %.0f requests/s\n", latency.size() / wall.count());
+    printf("Latency (us): p50 %.1f  p90 %.1f  p99 %.1f  max %.1f\n", percentile(latency, 0.50),
+           percentile(latency, 0.90), percentile(latency, 0.99), latency.empty() ? 0.0 : latency.back());
+    printf("Unreachable: %lu  Errors: %lu  Failed clients: %d\n", none, errors, failed);
+    return failed > 0 || errors > 0 ? 1 : 0;
+}
@@ -0,0 +1,373 @@
+/**
+ *          15-418 Final Project
+ *          Title:  Congestion Aware Map Routing
+ *          Credit: Parth Iyer   (pniyer@andrew.cmu.edu)
+ *                  Kwaku Baryeh (kbaryeh@andrew.cmu.edu)
+ */
+
+#include "graph.h"
+#include "options.h"
+#include "vehicles.h"
+#include "simulation.h"
+#include "astar.h"
+#include "log.h"
+#include <vector>
+#include <deque>
+#include <string>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <omp.h>
+
+/**
+ * Long-running route query service. The graph, the router's indexes and the
+ * live edge loads stay in memory, and requests are answered one per line:
+ *
+ *   ROUTE src dest     OK cost n v0 ... v(n-1), or NONE if dest is unreachable
+ *   LOAD u v n         OK; the edge from u to v now carries n vehicles
+ *   INFO               OK vertices edges
+ *   STATS              OK requests routes updates batches
+ *   SHUTDOWN           OK, and the server stops
+ *
+ * Anything else is answered with `ERR message`. Requests from every client
+ * are queued together and answered in batches: the routes between two load
+ * updates are searched in parallel over the OpenMP threads, and the replies
+ * go back to each client in the order it sent its requests.
+ *
+ * `./route_server <problem_file> [--socket PATH] [--threads T] [--query-batch N]
+ *      [--router R] [--edge-cost static|load] [--epsilon E] ...`
+ * Without --socket the server answers stdin on stdout until end of file.
+ */
+
+// --------------------------------------------------------------------
+// A client. The file descriptor is closed once the reader and every queued
+// request are done with it.
+struct Connection {
+    int in, out;
+
+    Connection(int in, int out) : in(in), out(out) {}
+    ~Connection() {
+        if (in > STDERR_FILENO)
+            close(in);
+        if (out > STDERR_FILENO && out != in)
+            close(out);
+    }
+};
+
+enum RequestType {
+    REQ_ROUTE,
+    REQ_LOAD,
+    REQ_INFO,
+    REQ_STATS,
+    REQ_SHUTDOWN,
+    REQ_BAD
+};
+
+struct Request {
+    std::shared_ptr<Connection> conn;
+    std::string line;
+    RequestType type;
+    int a, b, c;
+    std::string reply;
+};
+
+static std::mutex queue_lock;
+static std::condition_variable queue_ready;
+static std::deque<Request> pending;
+static bool input_closed = false;       // stdin mode: no more requests will come
+
+static unsigned long stat_requests, stat_routes, stat_updates, stat_batches;
+
+static bool write_all(int fd, const std::string &data) {
+    size_t done = 0;
+    while (done < data.size()) {
+        ssize_t n = write(fd, data.data() + done, data.size() - done);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        done += n;
+    }
+    return true;
+}
+
+// --------------------------------------------------------------------
+// Reads requests from a client until it hangs up.
+static void read_requests(std::shared_ptr<Connection> conn, bool closesInput) {
+    std::string buffer;
+    char chunk[65536];
+    ssize_t n;
+    while ((n = read(conn->in, chunk, sizeof(chunk))) != 0) {
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        buffer.append(chunk, n);
+        size_t start = 0, end;
+        std::vector<Request> lines;
+        while ((end = buffer.find('\n', start)) != std::string::npos) {
+            Request r;
+            r.conn = conn;
+            r.line = buffer.substr(start, end - start);
+            lines.push_back(std::move(r));
+            start = end + 1;
+        }
+        buffer.erase(0, start);
+        if (!lines.empty()) {
+            std::lock_guard<std::mutex> guard(queue_lock);
+            for (Request &r : lines)
+                pending.push_back(std::move(r));
+            queue_ready.notify_one();
+        }
+    }
+    if (closesInput) {
+        std::lock_guard<std::mutex> guard(queue_lock);
+        input_closed = true;
+        queue_ready.notify_one();
+    }
+}
+
+static void parse_request(const Graph &graph, Request &r) {
+    char word[16];
+    int n = graph.vertices.size();
+    r.type = REQ_BAD;
+    r.a = r.b = r.c = -1;
+    if (sscanf(r.line.c_str(), "%15s", word) != 1) {
+        r.reply = "ERR empty request\n";
+        return;
+    }
+    if (strcmp(word, "ROUTE") == 0) {
+        if (sscanf(r.line.c_str(), "ROUTE %d %d", &r.a, &r.b) != 2 ||
+            r.a < 0 || r.a >= n || r.b < 0 || r.b >= n) {
+            r.reply = "ERR usage: ROUTE src dest\n";
+            return;
+        }
+        r.type = REQ_ROUTE;
+    } else if (strcmp(word, "LOAD") == 0) {
+        if (sscanf(r.line.c_str(), "LOAD %d %d %d", &r.a, &r.b, &r.c) != 3 ||
+            r.a < 0 || r.a >= n || r.b < 0 || r.b >= n || r.c < 0) {
+            r.reply = "ERR usage: LOAD u v n\n";
+            return;
+        }
+        r.type = REQ_LOAD;
+    } else if (strcmp(word, "INFO") == 0) {
+        r.type = REQ_INFO;
+    } else if (strcmp(word, "STATS") == 0) {
+        r.type = REQ_STATS;
+    } else if (strcmp(word, "SHUTDOWN") == 0) {
+        r.type = REQ_SHUTDOWN;
+    } else {
+        r.reply = "ERR unknown request " + std::string(word) + "\n";
+    }
+}
+
+static void answer_route(const Graph &graph, Request &r) {
+    std::vector<int> path;
+    if (!find_route(graph, r.a, r.b, path)) {
+        r.reply = "NONE\n";
+        return;
+    }
+    long cost = 0;
+    for (size_t k = 1; k < path.size(); k++)
+        cost += edge_cost(graph, graph.edges[path[k - 1]][find_edge(graph, path[k - 1], path[k])]);
+    r.reply = "OK " + std::to_string(cost) + " " + std::to_string(path.size());
+    for (int v : path)
+        r.reply += " " + std::to_string(v);
+    r.reply += "\n";
+}
+
+// Sets the live load of an edge. Edges which ever carried load are kept in
+// vt.loaded, so the overlay can find the cells to recustomize.
+static void answer_load(const Graph &graph, VehicleTable &vt, std::vector<char> &listed, Request &r) {
+    int local = find_edge(graph, r.a, r.b);
+    if (local < 0) {
+        r.reply = "ERR no edge from " + std::to_string(r.a) + " to " + std::to_string(r.b) + "\n";
+        return;
+    }
+    int id = graph.edges[r.a][local].id;
+    vt.load[id] = r.c;
+    if (!listed[id]) {
+        listed[id] = 1;
+        vt.loaded.push_back({r.a, local});
+    }
+    r.reply = "OK\n";
+}
+
+// --------------------------------------------------------------------
+// Answers a batch: load updates and other requests one at a time, and the
+// routes between them in parallel.
+static bool answer_batch(const Graph &graph, VehicleTable &vt, std::vector<char> &listed,
+                         std::vector<Request> &batch) {
+    bool shutdown = false;
+    bool loadsChanged = false;
+    size_t k = 0;
+    while (k < batch.size()) {
+        Request &r = batch[k];
+        if (r.type == REQ_ROUTE) {
+            size_t end = k;
+            while (end < batch.size() && batch[end].type == REQ_ROUTE)
+                end++;
+            if (loadsChanged) {
+                refresh_route_metric(graph, vt);
+                loadsChanged = false;
+            }
+            #pragma omp parallel for schedule(dynamic)
+            for (size_t q = k; q < end; q++)
+                answer_route(graph, batch[q]);
+            stat_routes += end - k;
+            k = end;
+            continue;
+        }
+        switch (r.type) {
+        case REQ_LOAD:
+            answer_load(graph, vt, listed, r);
+            stat_updates++;
+            loadsChanged = true;
+            break;
+        case REQ_INFO:
+            r.reply = "OK " + std::to_string(graph.vertices.size()) + " " +
+                      std::to_string(graph.num_edges) + "\n";
+            break;
+        case REQ_STATS:
+            r.reply = "OK " + std::to_string(stat_requests) + " " + std::to_string(stat_routes) + " " +
+                      std::to_string(stat_updates) + " " + std::to_string(stat_batches) + "\n";
+            break;
+        case REQ_SHUTDOWN:
+            r.reply = "OK\n";
+            shutdown = true;
+            break;
+        default:
+            break;
+        }
+        k++;
+    }
+    if (loadsChanged)
+        refresh_route_metric(graph, vt);
+    return shutdown;
+}
+
+// --------------------------------------------------------------------
+// Takes batches off the queue until a client asks for a shutdown or, when
+// serving stdin, the input ends.
+static void serve(const Graph &graph, VehicleTable &vt, int maxBatch) {
+    std::vector<char> listed(graph.num_edges, 0);
+    bool shutdown = false;
+    while (!shutdown) {
+        std::vector<Request> batch;
+        {
+            std::unique_lock<std::mutex> guard(queue_lock);
+            queue_ready.wait(guard, [] { return !pending.empty() || input_closed; });
+            if (pending.empty())
+                break;
+            while (!pending.empty() && (int) batch.size() < maxBatch) {
+                batch.push_back(std::move(pending.front()));
+                pending.pop_front();
+            }
+        }
+        for (Request &r : batch)
+            parse_request(graph, r);
+        stat_requests += batch.size();
+        stat_batches++;
+        shutdown = answer_batch(graph, vt, listed, batch);
+        for (Request &r : batch)
+            write_all(r.conn->out, r.reply);
+    }
+}
+
+// --------------------------------------------------------------------
+static int listen_on(const std::string &path) {
+    struct sockaddr_un addr;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        LOG_ERROR("Socket path " << path << " is too long");
+        return -1;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        LOG_ERROR("socket failed: " << strerror(errno));
+        return -1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path.c_str());
+    unlink(path.c_str());
+    if (bind(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0 || listen(fd, 64) < 0) {
+        LOG_ERROR("Cannot listen on " << path << ": " << strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void accept_clients(int listenFd) {
+    int fd;
+    while ((fd = accept(listenFd, NULL, NULL)) >= 0 || errno == EINTR) {
+        if (fd < 0)
+            continue;
+        std::thread(read_requests, std::make_shared<Connection>(fd, fd), false).detach();
+    }
+}
+
+int main(int argc, char *argv[]) {
+    SimOptions opts;
+    if (!parse_sim_options(argc, argv, opts))
+        return 1;
+    // A client which hangs up must not take the server down with it.
+    signal(SIGPIPE, SIG_IGN);
+    if (opts.threads > 0)
+        omp_set_num_threads(opts.threads);
+
+    auto start = std::chrono::steady_clock::now();
+    Problem p = load_problem(opts.problem);
+    p.cars.clear();
+    VehicleTable vt;
+    init_vehicle_table(vt, p);
+
+    DistanceOracle oracle;
+    if (select_router(p.graph, opts, oracle))
+        use_distance_oracle(&oracle);
+    parse_edge_cost_mode(opts.edge_cost, edge_cost_mode);
+    OverlayGraph overlay;
+    if (select_overlay(p.graph, opts, overlay))
+        use_overlay(&overlay);
+    pin_search_graph(&p.graph);
+    use_edge_loads(vt.load.data());
+    use_weighted_routing(opts.epsilon, 0, false);
+    std::chrono::duration<double> ready = std::chrono::steady_clock::now() - start;
+    LOG_INFO("Serving " << (unsigned long) p.graph.vertices.size() << " vertices and "
+             << p.graph.num_edges << " edges on " << omp_get_max_threads() << " threads, ready after "
+             << ready.count() << " seconds");
+
+    int maxBatch = std::max(1, opts.query_batch);
+    if (opts.socket_path.empty()) {
+        std::thread reader(read_requests, std::make_shared<Connection>(STDIN_FILENO, STDOUT_FILENO), true);
+        reader.detach();
+        serve(p.graph, vt, maxBatch);
+    } else {
+        int listenFd = listen_on(opts.socket_path);
+        if (listenFd < 0)
+            return 1;
+        LOG_INFO("Listening on " << opts.socket_path);
+        std::thread acceptor(accept_clients, listenFd);
+        serve(p.graph, vt, maxBatch);
+        // Wakes the acceptor up; clients still connected are dropped on exit.
+        shutdown(listenFd, SHUT_RDWR);
+        close(listenFd);
+        acceptor.join();
+        unlink(opts.socket_path.c_str());
+    }
+
+    LOG_INFO("Answered " << stat_requests << " requests (" << stat_routes << " routes, "
+             << stat_updates << " load updates) in " << stat_batches << " batches");
+    return 0;
+}
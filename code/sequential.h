@@ -2,6 +2,7 @@
 #define SEQUENTIAL_H
 
 #include "graph.h"  // Contains definitions for Vertex, Edge, Graph, Car, Problem, etc.
+#include "options.h"
 #include <vector>
 using namespace std;
 
@@ -23,9 +24,7 @@ struct AStarNode {
 // The base cost for an edge).
 int computeManhattanCost(const Graph &graph, const Edge &edge);
 
-// Compute the dynamic cost of traversing an edge.
-// If an edge’s load is less than its capacity, then the cost is simply the Manhattan distance.
-// Otherwise, return INF to indicate the edge cannot be used.
+// Compute the dynamic cost of traversing an edge (see edge_cost in astar.h).
 float computeEdgeCost(const Graph &graph, const Edge &edge);
 
 // Returns the minimum Manhattan distance (base cost) among all edges in the graph.
@@ -47,6 +46,11 @@ void update_edge_weights(Graph &graph);
 
 // Advances the simulation in discrete time ticks. In each tick, every vehicle (if not at its destination)
 // is advanced along its planned route (or re-plans if necessary), then the loads on edges are updated.
+// Paths are streamed to opts.output_file as vehicles finish. Returns false if the simulation failed
+// or stopped with vehicles en route.
+bool simulate_discrete_time(Problem &p, const SimOptions &opts);
+
+// Option-less variant implemented by the CUDA build.
 void simulate_discrete_time(Problem &p);
 
 #endif // SEQUENTIAL_H
@@ -0,0 +1,452 @@
+/**
+ *          15-418 Final Project
+ *          Title:  Congestion Aware Map Routing
+ *          Credit: Parth Iyer   (pniyer@andrew.cmu.edu)
+ *                  Kwaku Baryeh (kbaryeh@andrew.cmu.edu)
+ */
+
+#include "simulation.h"
+#include "sequential.h"
+#include "log.h"
+#include "instrument.h"
+#include "astar.h"
+#include <cstring>
+#include <algorithm>
+
+static const DistanceOracle *route_oracle = NULL;
+static RouteSearch route_search = a_star_search<AStarQueue>;
+static OverlayGraph *route_overlay = NULL;
+static int reroute_slack = -1;
+static SpeculativeReroutes *route_spec = NULL;
+static double route_weight = 1.0;
+static int audit_every = 0;
+static bool refine_weighted = false;
+// Weighted routes not refined yet, carried over from tick to tick, and
+// whether each vehicle is among them.
+static std::vector<int> refine_pending;
+static std::vector<char> refine_queued;
+static int closed_edges = 0;
+static int gridlock_after = 0;
+
+// What weighted routing cost and saved, updated atomically from any thread.
+// The costs and times only cover the audited routes.
+static struct {
+    uint64_t routes, audited, refined, improved;
+    uint64_t weighted_cost, exact_cost;
+    uint64_t weighted_ns, exact_ns;
+} weighted_stats;
+
+void use_distance_oracle(const DistanceOracle *oracle) {
+    route_oracle = oracle;
+}
+
+void use_route_search(RouteSearch search) {
+    route_search = search != NULL ? search : a_star_search<AStarQueue>;
+}
+
+void use_overlay(OverlayGraph *overlay) {
+    route_overlay = overlay;
+}
+
+void refresh_route_metric(const Graph &graph, const VehicleTable &vt) {
+    if (route_overlay != NULL && edge_cost_mode == COST_LOAD)
+        customize_overlay_loads(graph, *route_overlay, vt.loaded);
+}
+
+void refresh_route_topology(const Graph &graph, const std::vector<EdgeRef> &changed, int closed) {
+    closed_edges = closed;
+    if (route_overlay != NULL)
+        customize_overlay_edges(graph, *route_overlay, changed);
+}
+
+void use_reroute_policy(int slack) {
+    reroute_slack = slack;
+}
+
+void use_gridlock_policy(int after) {
+    gridlock_after = after;
+}
+
+void use_speculation(SpeculativeReroutes *spec) {
+    route_spec = spec;
+}
+
+// Whether every edge of path is open.
+static bool route_open(const Graph &graph, const std::vector<int> &path) {
+    for (size_t k = 1; k < path.size(); k++) {
+        if (!edge_open(graph.edges[path[k - 1]][find_edge(graph, path[k - 1], path[k])]))
+            return false;
+    }
+    return true;
+}
+
+bool find_route(const Graph &graph, int start, int goal, std::vector<int> &path) {
+    // The oracle is not rebuilt when edges close; A* routes around them.
+    if (route_oracle != NULL) {
+        if (!oracle_route(*route_oracle, start, goal, path))
+            return false;
+        if (closed_edges == 0 || route_open(graph, path))
+            return true;
+        return route_search(graph, start, goal, path, -1, -1, route_weight);
+    }
+    if (route_overlay != NULL)
+        return overlay_route(graph, *route_overlay, start, goal, path);
+    return route_search(graph, start, goal, path, -1, -1, route_weight);
+}
+
+// --------------------------------------------------------------------
+// Weighted (bounded suboptimal) A* and its anytime refinement.
+void use_weighted_routing(double epsilon, int auditEvery, bool refine) {
+    route_weight = 1.0 + epsilon;
+    audit_every = auditEvery;
+    refine_weighted = refine && epsilon > 0;
+    refine_pending.clear();
+    refine_queued.clear();
+    memset(&weighted_stats, 0, sizeof(weighted_stats));
+}
+
+// The cost of route from index `from` on under edge_cost.
+static int route_metric(const Graph &graph, const std::vector<int> &route, int from) {
+    int cost = 0;
+    for (size_t k = from + 1; k < route.size(); k++) {
+        int local = find_edge(graph, route[k - 1], route[k]);
+        cost += edge_cost(graph, graph.edges[route[k - 1]][local]);
+    }
+    return cost;
+}
+
+// The cost of the rest of vehicle i's route under the Cost policy.
+template <class Cost>
+static int remaining_cost(const Graph &graph, const VehicleTable &vt, int i) {
+    const std::vector<uint8_t> &hops = vt.route[i];
+    int u = vt.position[i];
+    int cost = 0;
+    size_t pos = vt.cursor[i];
+    while (pos < hops.size()) {
+        const Edge &edge = graph.edges[u][get_hop(hops.data(), pos)];
+        cost += Cost::cost(graph, edge);
+        u = edge.start == u ? edge.end : edge.start;
+    }
+    return cost;
+}
+
+static uint64_t elapsed_ns(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - since).count();
+}
+
+// Plans a route for vehicle i with A*, weighted if use_weighted_routing asked
+// for it, and queues the vehicle for refinement.
+static bool plan_route(const Graph &graph, VehicleShard &shard, int i, int pos, int dest,
+                       std::vector<int> &route) {
+    if (route_weight == 1.0)
+        return route_search(graph, pos, dest, route, -1, -1, 1.0);
+
+    uint64_t n;
+    #pragma omp atomic capture
+    n = ++weighted_stats.routes;
+    if (audit_every <= 0 || n % audit_every != 0) {
+        bool found = route_search(graph, pos, dest, route, -1, -1, route_weight);
+        if (found && refine_weighted)
+            shard.refine.push_back(i);
+        return found;
+    }
+
+    // The second search finds the caches warm, so alternate which goes first.
+    std::vector<int> exact;
+    uint64_t weightedNs = 0, exactNs = 0;
+    bool found = false;
+    for (int pass = 0; pass < 2; pass++) {
+        auto start = std::chrono::steady_clock::now();
+        if ((pass == 0) == ((n / audit_every) % 2 == 0)) {
+            found = route_search(graph, pos, dest, route, -1, -1, route_weight);
+            weightedNs = elapsed_ns(start);
+        } else {
+            route_search(graph, pos, dest, exact, -1, -1, 1.0);
+            exactNs = elapsed_ns(start);
+        }
+    }
+    if (!found)
+        return false;
+    if (refine_weighted)
+        shard.refine.push_back(i);
+    uint64_t weightedCost = route_metric(graph, route, 0);
+    uint64_t exactCost = route_metric(graph, exact, 0);
+    #pragma omp atomic
+    weighted_stats.audited++;
+    #pragma omp atomic
+    weighted_stats.weighted_cost += weightedCost;
+    #pragma omp atomic
+    weighted_stats.exact_cost += exactCost;
+    #pragma omp atomic
+    weighted_stats.weighted_ns += weightedNs;
+    #pragma omp atomic
+    weighted_stats.exact_ns += exactNs;
+    return true;
+}
+
+int refine_routes(const Graph &graph, VehicleTable &vt, std::vector<VehicleShard> &shards,
+                  std::chrono::steady_clock::time_point deadline, bool parallel) {
+    // A vehicle replanned again while pending is queued once, so no two
+    // threads set its route below.
+    refine_queued.resize(vt.position.size(), 0);
+    for (VehicleShard &shard : shards) {
+        for (int i : shard.refine) {
+            if (!refine_queued[i]) {
+                refine_queued[i] = 1;
+                refine_pending.push_back(i);
+            }
+        }
+        shard.refine.clear();
+    }
+    // Cheapest remaining routes first: their searches are the shortest, so
+    // the most of them fit in the budget.
+    std::vector<std::pair<int, int>> todo;
+    for (int i : refine_pending) {
+        if (!vt.done[i] && vt.position[i] != vt.dest[i])
+            todo.push_back(std::make_pair(remaining_cost<EdgeCost>(graph, vt, i), i));
+        else
+            refine_queued[i] = 0;
+    }
+    std::sort(todo.begin(), todo.end());
+    std::vector<char> tried(todo.size(), 0);
+    int searched = 0, improved = 0;
+    #pragma omp parallel for schedule(dynamic) if (parallel) reduction(+:searched, improved)
+    for (int k = 0; k < (int) todo.size(); k++) {
+        if (std::chrono::steady_clock::now() >= deadline)
+            continue;
+        int i = todo[k].second;
+        std::vector<int> exact;
+        tried[k] = 1;
+        searched++;
+        if (!route_search(graph, vt.position[i], vt.dest[i], exact, -1, -1, 1.0) ||
+            route_metric(graph, exact, 0) >= todo[k].first)
+            continue;
+        LOG_DEBUG("Vehicle " << i << " refined route: " << exact);
+        set_route(graph, vt, i, exact);
+        improved++;
+    }
+    // The routes the deadline cut off wait for the next tick's budget.
+    refine_pending.clear();
+    for (size_t k = 0; k < todo.size(); k++) {
+        if (tried[k])
+            refine_queued[todo[k].second] = 0;
+        else
+            refine_pending.push_back(todo[k].second);
+    }
+    weighted_stats.refined += searched;
+    weighted_stats.improved += improved;
+    return searched;
+}
+
+void report_weighted_routing() {
+    if (weighted_stats.routes == 0)
+        return;
+    LOG_INFO("Weighted A* (epsilon " << route_weight - 1.0 << "): "
+             << (unsigned long) weighted_stats.routes << " routes, "
+             << (unsigned long) weighted_stats.audited << " audited against exact A*");
+    if (weighted_stats.audited > 0 && weighted_stats.exact_cost > 0 && weighted_stats.exact_ns > 0) {
+        double gap = 100.0 * ((double) weighted_stats.weighted_cost / weighted_stats.exact_cost - 1.0);
+        double ratio = (double) weighted_stats.weighted_ns / weighted_stats.exact_ns;
+        // Scale the time saved on the audited searches up to all weighted ones.
+        double savedMs = ((double) weighted_stats.exact_ns - weighted_stats.weighted_ns) / 1e6 *
+                         weighted_stats.routes / weighted_stats.audited;
+        LOG_INFO("Audited routes cost " << gap << "% more than exact ones; the searches took "
+                 << 100.0 * ratio << "% of the exact time, about " << savedMs
+                 << " ms saved over the run");
+    }
+    if (refine_weighted)
+        LOG_INFO("Refined " << (unsigned long) weighted_stats.refined << " routes within the tick budget, "
+                 << (unsigned long) weighted_stats.improved << " improved");
+}
+
+// --------------------------------------------------------------------
+// Detours searched ahead of the tick which needs them.
+static int route_cost(const Graph &graph, const std::vector<int> &route, int from) {
+    int cost = 0;
+    for (size_t k = from + 1; k < route.size(); k++) {
+        const Vertex &a = graph.vertices[route[k - 1]];
+        const Vertex &b = graph.vertices[route[k]];
+        cost += abs(a.x - b.x) + abs(a.y - b.y);
+    }
+    return cost;
+}
+
+void nominate_detour(const Graph &graph, const VehicleTable &vt, VehicleShard &shard, int i) {
+    if (!has_next_hop(vt, i))
+        return;
+    const Edge &edge = graph.edges[vt.position[i]][next_edge(vt, i)];
+    if (vt.load[edge.id] >= edge.capacity)
+        shard.speculate.push_back(i);
+}
+
+int collect_speculation(SpeculativeReroutes &spec, const Graph &graph, const VehicleTable &vt,
+                        std::vector<VehicleShard> &shards) {
+    spec.slot.resize(vt.position.size(), -1);
+    for (const Speculation &s : spec.entries) {
+        spec.slot[s.vehicle] = -1;
+        if (s.used)
+            spec.used++;
+        else
+            spec.discarded++;
+    }
+    spec.entries.clear();
+    for (VehicleShard &shard : shards) {
+        for (int i : shard.speculate) {
+            spec.slot[i] = spec.entries.size();
+            int avoid = hop_target(graph, vt.position[i], next_edge(vt, i));
+            spec.entries.push_back({i, vt.position[i], avoid, vt.dest[i], false, false, std::vector<int>()});
+        }
+        shard.speculate.clear();
+    }
+    return spec.entries.size();
+}
+
+void run_speculation(const Graph &graph, SpeculativeReroutes &spec, int k) {
+    Speculation &s = spec.entries[k];
+    s.found = route_search(graph, s.from, s.dest, s.route, s.from, s.avoid, route_weight);
+}
+
+// Moves vehicle i over `edge`, and notes it as the edge's entrant while
+// gridlocks are looked for.
+static void take_edge(const Graph &graph, VehicleTable &vt, VehicleShard &shard, int i, EdgeRef edge) {
+    advance_vehicle(graph, vt, shard, i, edge);
+    if (gridlock_after > 0)
+        shard.movers.push_back(i);
+}
+
+// Replans vehicle i around the full edge to nextNode, using a speculative
+// search if one matches. Returns false if the vehicle should wait instead.
+static bool reroute(const Graph &graph, VehicleTable &vt, VehicleShard &shard, int i,
+                    int nextNode, int tick) {
+    int pos = vt.position[i];
+    std::vector<int> detour;
+    bool found;
+    int k = route_spec != NULL ? route_spec->slot[i] : -1;
+    if (k >= 0 && route_spec->entries[k].from == pos && route_spec->entries[k].avoid == nextNode) {
+        Speculation &s = route_spec->entries[k];
+        s.used = true;
+        found = s.found;
+        detour.swap(s.route);
+    } else {
+        INSTR_COUNT(replans, 1);
+        INSTR_TIME(replan_ns);
+        found = route_search(graph, pos, vt.dest[i], detour, pos, nextNode, route_weight);
+    }
+    if (!found || detour.size() < 2)
+        return false;
+    int local = find_edge(graph, pos, detour[1]);
+    const Edge &first = graph.edges[pos][local];
+    if (vt.load[first.id] >= first.capacity ||
+        route_cost(graph, detour, 0) > remaining_cost<StaticCost>(graph, vt, i) + reroute_slack)
+        return false;
+
+    LOG_DEBUG("Vehicle " << i << " detours around the full edge to " << nextNode << ": " << detour);
+    TRACE_EVENT(tick, i, TRACE_REPLAN, pos, (int) detour.size());
+    set_route(graph, vt, i, detour);
+    take_edge(graph, vt, shard, i, {pos, local});
+    INSTR_COUNT(moves, 1);
+    TRACE_EVENT(tick, i, TRACE_ADVANCE, pos, vt.position[i]);
+    return true;
+}
+
+bool replan_around(const Graph &graph, VehicleTable &vt, int i, int tick) {
+    int pos = vt.position[i];
+    int nextNode = hop_target(graph, pos, next_edge(vt, i));
+    std::vector<int> detour;
+    bool found;
+    {
+        INSTR_COUNT(replans, 1);
+        INSTR_TIME(replan_ns);
+        found = route_search(graph, pos, vt.dest[i], detour, pos, nextNode, route_weight);
+    }
+    if (!found || detour.size() < 2)
+        return false;
+    LOG_DEBUG("Vehicle " << i << " leaves the gridlock at " << pos << " by " << detour);
+    TRACE_EVENT(tick, i, TRACE_REPLAN, pos, (int) detour.size());
+    set_route(graph, vt, i, detour);
+    return true;
+}
+
+// --------------------------------------------------------------------
+// One tick of one vehicle. Decisions only read the loads left by the previous
+// tick, so vehicles can be stepped in any order and on any thread.
+void step_vehicle(const Graph &graph, VehicleTable &vt, VehicleShard &shard, int i, int tick) {
+    int pos = vt.position[i];
+    bool needReplan = false;
+    int localIdx = -1;
+    if (!has_next_hop(vt, i)) {
+        if (pos == vt.dest[i]) {
+            shard.finished.push_back(i);
+            LOG_DEBUG("Vehicle " << i << " reached destination at node " << pos);
+            TRACE_EVENT(tick, i, TRACE_ARRIVE, pos, 0);
+            return;
+        }
+        LOG_DEBUG("Vehicle " << i << " has no route or route too short. Replanning.");
+        needReplan = true;
+    } else {
+        // The route names the edge to take next.
+        localIdx = next_edge(vt, i);
+        int nextNode = hop_target(graph, pos, localIdx);
+        if (!edge_open(graph.edges[pos][localIdx])) {
+            // A detour searched before the edge closed can still lead here.
+            LOG_DEBUG("Vehicle " << i << " found the edge from " << pos
+                      << " to " << nextNode << " closed. Replanning.");
+            needReplan = true;
+        } else {
+            const Edge &edge = graph.edges[pos][localIdx];
+            LOG_TRACE("Vehicle " << i << " sees edge from " << pos
+                      << " to " << nextNode << ": base cost = " << computeManhattanCost(graph, edge)
+                      << ", load = " << vt.load[edge.id] << ", capacity = " << edge.capacity);
+            if (vt.load[edge.id] >= edge.capacity) {
+                if (reroute_slack >= 0 && reroute(graph, vt, shard, i, nextNode, tick))
+                    return;
+                LOG_DEBUG("Vehicle " << i << " waiting at node " << pos
+                          << " because edge to " << nextNode << " is full.");
+                TRACE_EVENT(tick, i, TRACE_WAIT, pos, nextNode);
+                INSTR_COUNT(waits, 1);
+                vt.waited[i]++;
+                vt.held[i] = 1;
+                if (gridlock_after > 0)
+                    shard.blocked.push_back(i);
+                return;  // Skip this vehicle for this tick.
+            }
+        }
+    }
+
+    if (needReplan) {
+        vector<int> newRoute;
+        INSTR_COUNT(replans, 1);
+        bool found;
+        {
+            INSTR_TIME(replan_ns);
+            if (route_oracle == NULL && route_overlay == NULL)
+                found = plan_route(graph, shard, i, pos, vt.dest[i], newRoute);
+            else
+                found = find_route(graph, pos, vt.dest[i], newRoute);
+        }
+        if (found) {
+            LOG_DEBUG("Vehicle " << i << " replanned route: " << newRoute);
+            TRACE_EVENT(tick, i, TRACE_REPLAN, pos, (int) newRoute.size());
+            set_route(graph, vt, i, newRoute);
+        } else {
+            LOG_WARN("Vehicle " << i << " is stuck at node " << pos);
+            TRACE_EVENT(tick, i, TRACE_STUCK, pos, 0);
+            shard.finished.push_back(i);
+            return;
+        }
+        if (!has_next_hop(vt, i)) {
+            shard.finished.push_back(i);
+            LOG_DEBUG("Vehicle " << i << " reached destination at node " << pos);
+            TRACE_EVENT(tick, i, TRACE_ARRIVE, pos, 0);
+            return;
+        }
+        localIdx = next_edge(vt, i);
+    }
+
+    // Advance one edge.
+    take_edge(graph, vt, shard, i, {pos, localIdx});
+    INSTR_COUNT(moves, 1);
+    LOG_DEBUG("Vehicle " << i << " advanced to node " << vt.position[i]);
+    TRACE_EVENT(tick, i, TRACE_ADVANCE, pos, vt.position[i]);
+}
@@ -0,0 +1,233 @@
+/**
+ *          15-418 Final Project
+ *          Title:  Congestion Aware Map Routing
+ *          Credit: Parth Iyer   (pniyer@andrew.cmu.edu)
+ *                  Kwaku Baryeh (kbaryeh@andrew.cmu.edu)
+ */
+
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include "graph.h"
+#include "vehicles.h"
+#include "oracle.h"
+#include "overlay.h"
+#include <vector>
+#include <cstddef>
+#include <chrono>
+
+/**
+ * @name                Speculation
+ * @details             A detour searched ahead of time for a vehicle expected
+ *                      to find the edge from `from` to `avoid` full.
+ *
+ * @param vehicle       The vehicle the detour is for
+ * @param from          Its position when the search was started
+ * @param avoid         The vertex behind the edge the detour avoids
+ * @param dest          Its destination
+ * @param found         Whether the search found a route
+ * @param used          Set by step_vehicle when it takes the result
+ * @param route         The detour, from `from` to `dest`
+ */
+struct Speculation {
+    int vehicle;
+    int from;
+    int avoid;
+    int dest;
+    bool found;
+    bool used;
+    std::vector<int> route;
+};
+
+/**
+ * @name                SpeculativeReroutes
+ * @details             The detours searched while the serial phases of a tick
+ *                      run, for use by step_vehicle in the next tick. An entry
+ *                      is discarded if its vehicle no longer needs it, e.g.
+ *                      after a checkpoint resumed elsewhere.
+ *
+ * @param slot          Index of each vehicle's entry, or -1
+ * @param entries       This tick's speculations
+ * @param used          Speculations taken so far
+ * @param discarded     Speculations which turned out not to be needed
+ */
+struct SpeculativeReroutes {
+    std::vector<int> slot;
+    std::vector<Speculation> entries;
+    size_t used;
+    size_t discarded;
+
+    SpeculativeReroutes() : used(0), discarded(0) {}
+};
+
+/**
+ * @name                step_vehicle
+ * @details             Runs one tick for vehicle i: plans a route if it has
+ *                      none, waits if the next edge is full (or takes a detour,
+ *                      see use_reroute_policy) and otherwise moves one edge.
+ *                      Vehicles which arrive or get stuck are added to the
+ *                      shard's finished list.
+ *
+ * @param[in] graph     The graph, with the loads from the previous tick
+ * @param[in] tick      The current tick, for tracing
+ */
+void step_vehicle(const Graph &graph, VehicleTable &vt, VehicleShard &shard, int i, int tick);
+
+/**
+ * @name                find_route
+ * @details             Plans a route with the router in use: the oracle, the
+ *                      overlay or A* (weighted if use_weighted_routing asked for
+ *                      it). Safe to call from several threads while the loads
+ *                      and the overlay do not change.
+ *
+ * @param[out] path     The route, including start and goal
+ * @return              false if goal is unreachable
+ */
+bool find_route(const Graph &graph, int start, int goal, std::vector<int> &path);
+
+/**
+ * @name                use_distance_oracle
+ * @details             Makes step_vehicle plan routes by walking the oracle
+ *                      instead of running A*. Pass NULL to go back to A*.
+ */
+void use_distance_oracle(const DistanceOracle *oracle);
+
+/**
+ * @name                RouteSearch
+ * @details             An instantiation of a_star_search (see astar.h).
+ */
+typedef bool (*RouteSearch)(const Graph &graph, int start, int goal, std::vector<int> &path,
+                            int avoidFrom, int avoidTo, double weight);
+
+/**
+ * @name                use_route_search
+ * @details             Makes step_vehicle and the detour searches call the given
+ *                      A* variant. Pass NULL to go back to a_star_search with the
+ *                      compile-time queue and heuristic and the edge_cost metric.
+ */
+void use_route_search(RouteSearch search);
+
+/**
+ * @name                use_overlay
+ * @details             Makes step_vehicle plan routes on the overlay instead
+ *                      of running A*. Pass NULL to go back to A*.
+ */
+void use_overlay(OverlayGraph *overlay);
+
+/**
+ * @name                refresh_route_metric
+ * @details             Brings the overlay in use up to date with the loads of
+ *                      the tick about to start when routing with --edge-cost
+ *                      load. Call after update_edge_loads_current.
+ */
+void refresh_route_metric(const Graph &graph, const VehicleTable &vt);
+
+/**
+ * @name                refresh_route_topology
+ * @details             Tells the routers in use that the edges in `changed`
+ *                      were closed, reopened or changed capacity, and that
+ *                      `closed` edges are closed now. The overlay recustomizes
+ *                      the cells around them; the oracle keeps its table and
+ *                      its routes through a closed edge are searched with A*.
+ */
+void refresh_route_topology(const Graph &graph, const std::vector<EdgeRef> &changed, int closed);
+
+/**
+ * @name                use_reroute_policy
+ * @details             Lets a vehicle whose next edge is full replan around
+ *                      that edge instead of waiting, if the detour is at most
+ *                      `slack` longer than the rest of its route and its first
+ *                      edge is not full itself. A negative slack (the default)
+ *                      always waits.
+ */
+void use_reroute_policy(int slack);
+
+/**
+ * @name                use_gridlock_policy
+ * @details             Makes step_vehicle add every vehicle which waits to its
+ *                      shard's blocked list, for rings holding one which has
+ *                      waited `after` ticks (see gridlock.h). Pass 0 to stop
+ *                      (the default).
+ */
+void use_gridlock_policy(int after);
+
+/**
+ * @name                replan_around
+ * @details             Gives a waiting vehicle a new route avoiding the edge
+ *                      it waits for, however much longer, to break a gridlock.
+ *                      The vehicle moves on the next tick. Thread safe for
+ *                      distinct vehicles.
+ *
+ * @return              false if there is no such route
+ */
+bool replan_around(const Graph &graph, VehicleTable &vt, int i, int tick);
+
+/**
+ * @name                use_speculation
+ * @details             Makes step_vehicle take detours from `spec` when one was
+ *                      searched for its position and blocked edge. Pass NULL
+ *                      to search every detour on demand.
+ */
+void use_speculation(SpeculativeReroutes *spec);
+
+/**
+ * @name                use_weighted_routing
+ * @details             Makes step_vehicle plan its A* routes with the heuristic
+ *                      weighted by 1 + epsilon, so each may cost up to that
+ *                      factor more than the exact route. Every auditEvery-th
+ *                      weighted route is also searched exactly, to measure the
+ *                      realized gap and the search time saved. With `refine`,
+ *                      the vehicles are collected for refine_routes. Resets the
+ *                      statistics; pass 0 to route exactly again.
+ */
+void use_weighted_routing(double epsilon, int auditEvery, bool refine);
+
+/**
+ * @name                refine_routes
+ * @details             The anytime part of weighted routing: replaces the
+ *                      weighted routes of the vehicles still en route by exact
+ *                      ones, if they are cheaper, until the deadline passes.
+ *                      Takes the shards' refine lists, refines the routes with
+ *                      the least cost left first and keeps the rest for the
+ *                      next call. Call after the step phase, before the loads
+ *                      change.
+ *
+ * @param[in] parallel  Spread the searches over the OpenMP threads
+ * @return              The number of routes searched again
+ */
+int refine_routes(const Graph &graph, VehicleTable &vt, std::vector<VehicleShard> &shards,
+                  std::chrono::steady_clock::time_point deadline, bool parallel);
+
+/**
+ * @name                report_weighted_routing
+ * @details             Logs how many routes were weighted, audited and refined,
+ *                      the cost gap of the audited routes over exact ones and
+ *                      the search time saved, if weighted routing was used.
+ */
+void report_weighted_routing();
+
+/**
+ * @name                nominate_detour
+ * @details             Adds vehicle i to shard.speculate if its next edge is
+ *                      full by the current loads.
+ */
+void nominate_detour(const Graph &graph, const VehicleTable &vt, VehicleShard &shard, int i);
+
+/**
+ * @name                collect_speculation
+ * @details             Retires the previous round and turns the shards'
+ *                      nominations into entries to search.
+ *
+ * @return              The number of entries to search
+ */
+int collect_speculation(SpeculativeReroutes &spec, const Graph &graph, const VehicleTable &vt,
+                        std::vector<VehicleShard> &shards);
+
+/**
+ * @name                run_speculation
+ * @details             Searches entry k. Only reads the graph's topology and
+ *                      the entry, so it can run alongside the output phase.
+ */
+void run_speculation(const Graph &graph, SpeculativeReroutes &spec, int k);
+
+#endif // SIMULATION_H
@@ -0,0 +1,215 @@
+/**
+ *          15-418 Final Project
+ *          Title:  Congestion Aware Map Routing
+ *          Credit: Parth Iyer   (pniyer@andrew.cmu.edu)
+ *                  Kwaku Baryeh (kbaryeh@andrew.cmu.edu)
+ */
+
+#include "solution_writer.h"
+#include "encoding.h"
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <cstdlib>
+#include <unistd.h>
+
+static void append_text(std::string &out, int id, const std::vector<int> &path) {
+    char buf[16];
+    int n = snprintf(buf, sizeof(buf), "%d:", id);
+    out.append(buf, n);
+    for (size_t j = 0; j < path.size(); j++) {
+        n = snprintf(buf, sizeof(buf), j + 1 < path.size() ? "%d," : "%d", path[j]);
+        out.append(buf, n);
+    }
+    out += '\n';
+}
+
+void encode_path_binary(std::vector<uint8_t> &out, int id, const std::vector<int> &path) {
+    put_varint(out, id);
+    put_varint(out, path.size());
+    for (size_t j = 0; j < path.size(); j++) {
+        if (j == 0)
+            put_varint(out, path[0]);
+        else
+            put_varint(out, zigzag(path[j] - path[j - 1]));
+    }
+}
+
+static void writer_loop(SolutionWriter *w) {
+    std::vector<PendingPath> batch;
+    std::string text;
+    std::vector<uint8_t> bytes;
+    std::vector<int> path;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> guard(w->lock);
+            while (w->pending.empty() && !w->closing)
+                w->ready.wait(guard);
+            if (w->pending.empty() && w->closing)
+                break;
+            batch.swap(w->pending);
+            w->pendingHops = 0;
+        }
+
+        // Encode and write outside the lock so the simulation can keep submitting.
+        text.clear();
+        bytes.clear();
+        for (const PendingPath &entry : batch) {
+            path.assign(1, entry.origin);
+            decode_hops(*w->graph, entry.origin, entry.hops, 0, path);
+            if (w->format == FORMAT_TEXT)
+                append_text(text, entry.id, path);
+            else
+                encode_path_binary(bytes, entry.id, path);
+        }
+        if (w->format == FORMAT_TEXT)
+            fwrite(text.data(), 1, text.size(), w->file);
+        else
+            fwrite(bytes.data(), 1, bytes.size(), w->file);
+        {
+            std::lock_guard<std::mutex> guard(w->lock);
+            w->written += batch.size();
+        }
+        w->drained.notify_all();
+        batch.clear();
+    }
+}
+
+bool parse_solution_format(const std::string &name, SolutionFormat &format) {
+    if (name == "text")
+        format = FORMAT_TEXT;
+    else if (name == "binary")
+        format = FORMAT_BINARY;
+    else
+        return false;
+    return true;
+}
+
+bool open_solution_writer(SolutionWriter &w, const Graph &graph, const std::string &fname,
+                          SolutionFormat format, long offset, size_t written) {
+    if (offset >= 0) {
+        // Drop whatever was written after the checkpoint and append from there.
+        if (truncate(fname.c_str(), offset) != 0)
+            return false;
+        w.file = fopen(fname.c_str(), "ab");
+    } else {
+        w.file = fopen(fname.c_str(), "wb");
+    }
+    if (w.file == NULL)
+        return false;
+    w.format = format;
+    w.graph = &graph;
+    w.pending.clear();
+    w.pendingHops = 0;
+    w.maxPendingHops = 1 << 22;
+    w.submitted = offset >= 0 ? written : 0;
+    w.written = w.submitted;
+    w.closing = false;
+    if (format == FORMAT_BINARY && offset < 0)
+        fwrite(SOLUTION_MAGIC, 1, strlen(SOLUTION_MAGIC), w.file);
+    w.worker = std::thread(writer_loop, &w);
+    return true;
+}
+
+void submit_path(SolutionWriter &w, int id, int origin, std::vector<uint8_t> &hops) {
+    std::unique_lock<std::mutex> guard(w.lock);
+    while (w.pendingHops > w.maxPendingHops)
+        w.drained.wait(guard);
+    w.pendingHops += hops.size();
+    w.submitted++;
+    w.pending.push_back(PendingPath{id, origin, std::vector<uint8_t>()});
+    w.pending.back().hops.swap(hops);
+    guard.unlock();
+    w.ready.notify_one();
+}
+
+long sync_solution_writer(SolutionWriter &w) {
+    std::unique_lock<std::mutex> guard(w.lock);
+    while (w.written < w.submitted)
+        w.drained.wait(guard);
+    fflush(w.file);
+    return ftell(w.file);
+}
+
+void stream_finished(SolutionWriter &w, VehicleTable &t, std::vector<VehicleShard> &shards) {
+    for (VehicleShard &shard : shards) {
+        for (int i : shard.finished) {
+            submit_path(w, i, t.origin[i], t.path[i]);
+            std::vector<uint8_t>().swap(t.route[i]);
+        }
+    }
+}
+
+size_t close_solution_writer(SolutionWriter &w, VehicleTable &t) {
+    // Vehicles cut off by the tick limit still get their partial path written.
+    for (int i : t.active)
+        submit_path(w, i, t.origin[i], t.path[i]);
+    {
+        std::lock_guard<std::mutex> guard(w.lock);
+        w.closing = true;
+    }
+    w.ready.notify_one();
+    w.worker.join();
+    fclose(w.file);
+    w.file = NULL;
+    return w.written;
+}
+
+bool read_solution(const std::string &fname, size_t vehicles, std::vector<std::vector<int>> &paths) {
+    std::ifstream file(fname.c_str(), std::ios::binary);
+    if (!file.is_open())
+        return false;
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    std::string data = buffer.str();
+    size_t magic = strlen(SOLUTION_MAGIC);
+
+    if (data.compare(0, magic, SOLUTION_MAGIC) == 0) {
+        const uint8_t *bytes = (const uint8_t *) data.data();
+        size_t pos = magic;
+        while (pos < data.size()) {
+            uint32_t id, len, v;
+            // Every vertex takes at least a byte, so a longer path is corrupt.
+            if (!get_varint(bytes, data.size(), pos, id) || !get_varint(bytes, data.size(), pos, len) ||
+                id >= vehicles || len > data.size() - pos)
+                return false;
+            if (id >= paths.size())
+                paths.resize(id + 1);
+            std::vector<int> &path = paths[id];
+            path.resize(len);
+            for (uint32_t j = 0; j < len; j++) {
+                if (!get_varint(bytes, data.size(), pos, v))
+                    return false;
+                path[j] = j == 0 ? (int) v : path[j - 1] + unzigzag(v);
+            }
+        }
+        return true;
+    }
+
+    std::stringstream ss(data);
+    std::string line;
+    while (std::getline(ss, line, '\n')) {
+        size_t colon = line.find(":");
+        if (colon == std::string::npos)
+            continue;
+        const char *text = line.c_str();
+        char *idEnd;
+        long id = strtol(text, &idEnd, 10);
+        if (idEnd == text || idEnd != text + colon || id < 0 || id >= (long) vehicles)
+            return false;
+        if (id >= (long) paths.size())
+            paths.resize(id + 1);
+        std::vector<int> &path = paths[id];
+        path.clear();
+        const char *p = line.c_str() + colon + 1;
+        while (*p != '\0') {
+            char *end;
+            long v = strtol(p, &end, 10);
+            if (end == p)
+                return false;
+            path.push_back((int) v);
+            p = *end == ',' ? end + 1 : end;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,150 @@
+/**
+ *          15-418 Final Project
+ *          Title:  Congestion Aware Map Routing
+ *          Credit: Parth Iyer   (pniyer@andrew.cmu.edu)
+ *                  Kwaku Baryeh (kbaryeh@andrew.cmu.edu)
+ */
+
+#ifndef SOLUTION_WRITER_H
+#define SOLUTION_WRITER_H
+
+#include "vehicles.h"
+#include <vector>
+#include <string>
+#include <utility>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <stdio.h>
+
+#define SOLUTION_MAGIC "RTS1"
+
+/**
+ * @name                SolutionFormat
+ * @details             TEXT writes `id:v0,v1,...` lines as read by
+ *                      validator.py. BINARY writes the SOLUTION_MAGIC header
+ *                      followed by one record per vehicle: varint id, varint
+ *                      hop count, varint first vertex and then the zigzag
+ *                      varint delta of every following vertex.
+ */
+enum SolutionFormat {
+    FORMAT_TEXT,
+    FORMAT_BINARY
+};
+
+/**
+ * @name                PendingPath
+ * @details             A finished path as the vehicle table holds it: its
+ *                      origin and its hops (see put_hop).
+ */
+struct PendingPath {
+    int id;
+    int origin;
+    std::vector<uint8_t> hops;
+};
+
+/**
+ * @name                SolutionWriter
+ * @details             Streams vehicle paths to the solution file from a
+ *                      background thread while the simulation keeps running.
+ *                      Paths are written in the order the vehicles finish, so
+ *                      the id prefix of each record identifies the vehicle.
+ *                      The writer turns the hops back into vertices, so the
+ *                      simulation only hands over the compact paths.
+ *
+ * @param file          The open solution file
+ * @param format        The encoding of the records
+ * @param graph         The graph the hops are decoded on
+ * @param pending       Paths handed over but not yet written
+ * @param pendingHops   Total hop bytes in `pending`, bounded by maxPendingHops
+ * @param submitted     Number of paths handed over so far
+ * @param written       Number of paths written so far
+ */
+struct SolutionWriter {
+    FILE *file;
+    SolutionFormat format;
+    const Graph *graph;
+    std::vector<PendingPath> pending;
+    size_t pendingHops;
+    size_t maxPendingHops;
+    size_t submitted;
+    size_t written;
+    bool closing;
+    std::mutex lock;
+    std::condition_variable ready;
+    std::condition_variable drained;
+    std::thread worker;
+};
+
+/**
+ * @name                parse_solution_format
+ * @details             Parses "text" or "binary".
+ *
+ * @return              false if the name is unknown
+ */
+bool parse_solution_format(const std::string &name, SolutionFormat &format);
+
+/**
+ * @name                open_solution_writer
+ * @details             Opens the solution file and starts the writer thread.
+ *                      When resuming from a checkpoint, `offset` and `written`
+ *                      are the values sync_solution_writer() returned when the
+ *                      checkpoint was taken; the file is cut back to that
+ *                      offset and appended to.
+ *
+ * @return              false if the file can not be opened
+ */
+bool open_solution_writer(SolutionWriter &w, const Graph &graph, const std::string &fname,
+                          SolutionFormat format, long offset = -1, size_t written = 0);
+
+/**
+ * @name                sync_solution_writer
+ * @details             Waits until every submitted path is in the file.
+ *
+ * @return              The file offset just past the last written record
+ */
+long sync_solution_writer(SolutionWriter &w);
+
+/**
+ * @name                submit_path
+ * @details             Hands a finished path to the writer. The hops are moved
+ *                      out of the caller's vector. Blocks while the writer is
+ *                      more than maxPendingHops hops behind.
+ */
+void submit_path(SolutionWriter &w, int id, int origin, std::vector<uint8_t> &hops);
+
+/**
+ * @name                stream_finished
+ * @details             Submits the path of every vehicle in the shards'
+ *                      finished lists and releases it from the table. Call
+ *                      before retire_vehicles().
+ */
+void stream_finished(SolutionWriter &w, VehicleTable &t, std::vector<VehicleShard> &shards);
+
+/**
+ * @name                close_solution_writer
+ * @details             Submits the paths of the vehicles still in the table,
+ *                      waits for everything to be written and closes the file.
+ *
+ * @return              The number of paths written
+ */
+size_t close_solution_writer(SolutionWriter &w, VehicleTable &t);
+
+/**
+ * @name                encode_path_binary
+ * @details             Appends the binary record for one path to `out`.
+ */
+void encode_path_binary(std::vector<uint8_t> &out, int id, const std::vector<int> &path);
+
+/**
+ * @name                read_solution
+ * @details             Reads a text or binary solution file into one path per
+ *                      vehicle, indexed by vehicle id.
+ *
+ * @param vehicles      The number of cars of the problem; an id at or above
+ *                      it is malformed
+ * @return              false if the file is missing or malformed
+ */
+bool read_solution(const std::string &fname, size_t vehicles, std::vector<std::vector<int>> &paths);
+
+#endif // SOLUTION_WRITER_H
@@ -0,0 +1,40 @@
+#include "graph.h"
+#include "distributed.h"
+#include "options.h"
+#include <stdio.h>
+
+/**
+ * `./test_distributed <problem_file> --ranks N [--scaling]`
+ * With --scaling the simulation is repeated with 1, 2, ..., N ranks and a
+ * table of times and speedups over one rank is printed.
+ */
+int main(int argc, char *argv[]) {
+    SimOptions opts;
+    if (!parse_sim_options(argc, argv, opts))
+        return 1;
+
+    Problem p = load_problem(opts.problem);
+
+    if (!opts.scaling) {
+        double seconds = simulate_distributed(p, opts);
+        if (seconds < 0)
+            return 1;
+        printf("Simulation completed in %g seconds with %d ranks.\n", seconds, opts.ranks);
+        return 0;
+    }
+
+    printf("ranks,seconds,speedup\n");
+    int maxRanks = opts.ranks;
+    double base = 0;
+    for (int r = 1; r <= maxRanks; r++) {
+        opts.ranks = r;
+        double seconds = simulate_distributed(p, opts);
+        if (seconds < 0)
+            return 1;
+        if (r == 1)
+            base = seconds;
+        printf("%d,%g,%.2f\n", r, seconds, base / seconds);
+        fflush(stdout);
+    }
+    return 0;
+}
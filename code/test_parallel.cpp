@@ -1,20 +1,20 @@
 #include "graph.h"
 #include "sequential.h"
+#include "options.h"
+#include "batch.h"
 #include <iostream>
 #include <string>
 #include <cstdlib>
 using namespace std;
 
 int main(int argc, char *argv[]) {
-    if (argc < 2) {
-        cerr << "Usage: " << argv[0] << " <problem_file>" << endl;
+    SimOptions opts;
+    if (!parse_sim_options(argc, argv, opts))
         return 1;
-    }
-    
-    string filename = argv[1];
-    Problem p = load_problem(filename);
 
-    simulate_discrete_time(p);
+    Problem p = load_problem(opts.problem);
 
-    return 0;
+    if (!opts.batch_file.empty())
+        return run_batch(p, opts) == 0 ? 0 : 1;
+    return simulate_discrete_time(p, opts) ? 0 : 1;
 }
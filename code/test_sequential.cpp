@@ -1,21 +1,18 @@
 #include "graph.h"
 #include "sequential.h"
+#include "options.h"
 #include <iostream>
 #include <string>
 #include <cstdlib>
 using namespace std;
 
 int main(int argc, char* argv[]) {
-    if (argc < 2) {
-        cerr << "Usage: " << argv[0] << " <problem_file>" << endl;
+    SimOptions opts;
+    if (!parse_sim_options(argc, argv, opts))
         return 1;
-    }
-    
-    string filename = argv[1];
-    Problem p = load_problem(filename);
+
+    Problem p = load_problem(opts.problem);
 
     // Run the discrete time simulation.
-    simulate_discrete_time(p);
-    
-    return 0;
+    return simulate_discrete_time(p, opts) ? 0 : 1;
 }
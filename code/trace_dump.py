@@ -0,0 +1,30 @@
+import argparse, struct
+
+EVENTS = {1: 'advance', 2: 'wait', 3: 'replan', 4: 'arrive', 5: 'stuck', 6: 'depart', 7: 'gridlock'}
+RECORD = struct.Struct('<5i')
+
+def read_trace(file_name : str):
+    data = open(file_name, "rb").read()
+    for off in range(0, len(data) - RECORD.size + 1, RECORD.size):
+        yield RECORD.unpack_from(data, off)
+
+def main ():
+    parser = argparse.ArgumentParser("Prints or summarizes a binary simulation trace")
+    parser.add_argument('trace', type=str, help='The trace file written with --trace')
+    parser.add_argument('-s', '--summary', action='store_true', help='Only print event counts per tick')
+
+    args = parser.parse_args()
+    records = sorted(read_trace(args.trace), key=lambda r: (r[0], r[1]))
+    if args.summary:
+        counts = {}
+        for tick, _, event, _, _ in records:
+            counts.setdefault(tick, {}).setdefault(EVENTS.get(event, event), 0)
+            counts[tick][EVENTS.get(event, event)] += 1
+        for tick in sorted(counts):
+            print(f'{tick}: {counts[tick]}')
+    else:
+        for tick, vehicle, event, a, b in records:
+            print(f'{tick} {vehicle} {EVENTS.get(event, event)} {a} {b}')
+
+if __name__ == "__main__":
+    main()
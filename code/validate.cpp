@@ -0,0 +1,203 @@
+/**
+ *          15-418 Final Project
+ *          Title:  Congestion Aware Map Routing
+ *          Credit: Parth Iyer   (pniyer@andrew.cmu.edu)
+ *                  Kwaku Baryeh (kbaryeh@andrew.cmu.edu)
+ */
+
+#include "graph.h"
+#include "solution_writer.h"
+#include "vehicles.h"
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <stdio.h>
+#include <omp.h>
+
+/**
+ * Native replacement for validator.py with the same checks, the same
+ * simulation semantics and the same output.
+ *
+ * `./validate <problem_file> <solution_file> [-s]`
+ */
+
+// --------------------------------------------------------------------
+// The first edge in edges[u] ending at v, like get_edge() in validator.py.
+static int get_edge(const Graph &graph, int u, int v) {
+    const EdgeList &list = graph.edges[u];
+    for (int k = 0; k < (int) list.size(); k++)
+        if (list[k].end == v)
+            return k;
+    return -1;
+}
+
+static int get_cost(const Graph &graph, const Edge &e) {
+    const Vertex &a = graph.vertices[e.start];
+    const Vertex &b = graph.vertices[e.end];
+    return abs(b.x - a.x) + abs(b.y - a.y);
+}
+
+enum Failure {
+    FAIL_NONE = 0,
+    FAIL_GRAPH = 1,
+    FAIL_PATH = 2
+};
+
+// --------------------------------------------------------------------
+// Checks every car's path in parallel and returns the failure of the first
+// bad car, which is what the sequential Python loop would have reported.
+static Failure validate_solution(const Problem &p, const std::vector<std::vector<int>> &paths) {
+    int nCars = p.cars.size();
+    int nVertices = p.graph.vertices.size();
+    int firstBad = nCars;
+
+    #pragma omp parallel for schedule(dynamic, 1024) reduction(min:firstBad)
+    for (int i = 0; i < nCars; i++) {
+        const Car &c = p.cars[i];
+        bool ok = i < (int) paths.size() && !paths[i].empty() &&
+                  c.src >= 0 && c.src < nVertices && c.dest >= 0 && c.dest < nVertices &&
+                  paths[i].front() == c.src && paths[i].back() == c.dest;
+        for (size_t j = 1; ok && j < paths[i].size(); j++) {
+            int u = paths[i][j - 1];
+            int v = paths[i][j];
+            ok = u >= 0 && u < nVertices && get_edge(p.graph, u, v) >= 0;
+        }
+        if (!ok && i < firstBad)
+            firstBad = i;
+    }
+
+    if (firstBad == nCars)
+        return FAIL_NONE;
+
+    // Work out which message validator.py prints for this car.
+    const Car &c = p.cars[firstBad];
+    if (firstBad < (int) paths.size() && !paths[firstBad].empty() &&
+        c.src >= 0 && c.src < nVertices && c.dest >= 0 && c.dest < nVertices &&
+        paths[firstBad].front() == c.src && paths[firstBad].back() == c.dest)
+        return FAIL_PATH;
+    return FAIL_GRAPH;
+}
+
+// --------------------------------------------------------------------
+// Replays validator.py's simulate(). Each car acts when its waiting counter
+// reaches zero: a blocked car acts again next tick and a car that enters an
+// edge of cost c acts again c ticks later. Instead of visiting every car every
+// tick, cars are kept in a timing wheel keyed by the tick they next act at,
+// and each tick's cars are processed in id order so loads change in exactly
+// the order the Python loop changes them. A car first acts on its departure
+// tick.
+static bool simulate(const Graph &graph, const Problem &p, const std::vector<std::vector<int>> &paths,
+                     std::vector<long> &costs) {
+    int nCars = p.cars.size();
+    int maxCost = 1;
+    for (const auto &list : graph.edges)
+        for (const Edge &e : list)
+            maxCost = std::max(maxCost, get_cost(graph, e));
+
+    std::vector<int> load(graph.num_edges, 0);  // By Edge::id.
+
+    int wheelSize = maxCost + 1;
+    std::vector<std::vector<int>> wheel(wheelSize);
+    std::vector<size_t> next(nCars, 1);        // Index of the next vertex in the path.
+    std::vector<EdgeRef> cursor(nCars);        // The edge each car is on.
+    costs.assign(nCars, 0);
+    std::vector<int> departures(nCars);
+    for (int i = 0; i < nCars; i++) {
+        departures[i] = i;
+        cursor[i] = {-1, -1};
+    }
+    std::stable_sort(departures.begin(), departures.end(),
+                     [&p](int a, int b) { return p.cars[a].depart < p.cars[b].depart; });
+
+    long scheduled = 0;
+    int departed = 0;
+    for (long tick = 0; scheduled > 0 || departed < nCars; tick++) {
+        // Nothing happens until the next departure when the roads are empty.
+        if (scheduled == 0)
+            tick = std::max(tick, (long) p.cars[departures[departed]].depart);
+        std::vector<int> &bucket = wheel[tick % wheelSize];
+        std::vector<int> acting;
+        acting.swap(bucket);
+        scheduled -= acting.size();
+        while (departed < nCars && p.cars[departures[departed]].depart <= tick)
+            acting.push_back(departures[departed++]);
+        std::sort(acting.begin(), acting.end());
+
+        for (int i : acting) {
+            const std::vector<int> &path = paths[i];
+            if (next[i] == path.size()) {
+                if (cursor[i].vertex >= 0)
+                    load[graph.edges[cursor[i].vertex][cursor[i].local].id]--;
+                continue;
+            }
+
+            int u = path[next[i] - 1];
+            int k = get_edge(graph, u, path[next[i]]);
+            const Edge &edge = graph.edges[u][k];
+            int wait;
+            if (load[edge.id] == edge.capacity) {
+                wait = 1;
+            } else {
+                if (cursor[i].vertex >= 0)
+                    load[graph.edges[cursor[i].vertex][cursor[i].local].id]--;
+                load[edge.id]++;
+                wait = get_cost(graph, edge);
+                cursor[i] = {u, k};
+                next[i]++;
+            }
+            costs[i] += wait;
+            if (wait <= 0) {
+                fprintf(stderr, "Car %d entered a zero cost edge; validator.py would never terminate\n", i);
+                return false;
+            }
+            wheel[(tick + wait) % wheelSize].push_back(i);
+            scheduled++;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    bool runSimulation = false;
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-s") == 0 || strcmp(argv[i], "--simulate") == 0)
+            runSimulation = true;
+        else
+            files.push_back(argv[i]);
+    }
+    if (files.size() != 2) {
+        fprintf(stderr, "Usage: %s <problem_file> <solution_file> [-s]\n", argv[0]);
+        return 1;
+    }
+
+    Problem p = load_problem(files[0]);
+    std::vector<std::vector<int>> paths;
+    if (!read_solution(files[1], p.cars.size(), paths)) {
+        fprintf(stderr, "Unable to read solution file %s\n", files[1].c_str());
+        return 1;
+    }
+
+    Failure failure = validate_solution(p, paths);
+    if (failure != FAIL_NONE) {
+        printf(failure == FAIL_PATH ? "Validation Failed! Path is not correct\n"
+                                    : "Validation Failed! Graph is not correct\n");
+        printf("Validation Failed!\n");
+        return 0;
+    }
+
+    if (runSimulation) {
+        std::vector<long> costs;
+        if (!simulate(p.graph, p, paths, costs))
+            return 1;
+        long total = 0;
+        for (long c : costs)
+            total += c;
+        printf("Total Cost: %ld\n", total);
+        for (size_t i = 0; i < p.cars.size(); i++)
+            printf("(%d,%d): %ld\n", p.cars[i].src, p.cars[i].dest, costs[i]);
+    }
+    return 0;
+}
@@ -20,9 +20,10 @@ class Edge:
         return f'({self.start},{self.end},{self.capacity}, {self.load}, {self.cost})'
 
 class Car:
-    def __init__(self, src : int, dest : int):
+    def __init__(self, src : int, dest : int, depart : int = 0):
         self.src = src
         self.dest = dest
+        self.depart = depart
         self.path = []
     
     def __repr__(self):
@@ -71,16 +72,44 @@ def parse_problem(file_name : str):
         else:
             v = graphFile[i].split(",")
             if (v[0] != ''):
-                cars.append(Car(int(v[0].strip("()")), int(v[1].strip("()"))))
+                depart = int(v[2].strip("()")) if len(v) > 2 else 0
+                cars.append(Car(int(v[0].strip("()")), int(v[1].strip("()")), depart))
     
     return vertices, edges, cars
 
 
+def read_varint(data : bytes, pos : int):
+    v, shift = 0, 0
+    while True:
+        b = data[pos]
+        pos += 1
+        v |= (b & 0x7f) << shift
+        shift += 7
+        if b & 0x80 == 0:
+            return v, pos
+
+
 def parse_solution(file_name : str, cars : list[Car]):
-    solnFile = open(file_name, "r").read().split("\n")
-    
-    for i in range(len(cars)):
-        cars[i].path = list(map(int,solnFile[i].split(":")[1].split(",")))
+    data = open(file_name, "rb").read()
+
+    # Binary solutions: magic, then (id, length, first vertex, zigzag deltas...) varints
+    if data[:4] == b'RTS1':
+        pos = 4
+        while pos < len(data):
+            id, pos = read_varint(data, pos)
+            n, pos = read_varint(data, pos)
+            path = []
+            for j in range(n):
+                v, pos = read_varint(data, pos)
+                path.append(v if j == 0 else path[-1] + ((v >> 1) ^ -(v & 1)))
+            cars[id].path = path
+        return
+
+    # Text solutions: one "id:v0,v1,..." line per car, in any order
+    for line in data.decode().split("\n"):
+        if ":" in line:
+            id, path = line.split(":")
+            cars[int(id)].path = list(map(int, path.split(",")))
 
 
 def validate_solution(cars : list[Car], edges : list[list[Edge]]):
@@ -110,7 +139,8 @@ def simulate(vertices : list[Vertex], edges : list[list[Edge]], cars : list[Car]
     for i in range(len(cars)):
         locs.append(cars[i].path.pop(0))
         cursor.append(Edge(-1,-1,-1))
-        waiting.append(0)
+        # A car first acts on its departure tick; the wait is not part of its cost.
+        waiting.append(cars[i].depart)
         costs.append(0)
 
     # Run the simulation
@@ -0,0 +1,151 @@
+/**
+ *          15-418 Final Project
+ *          Title:  Congestion Aware Map Routing
+ *          Credit: Parth Iyer   (pniyer@andrew.cmu.edu)
+ *                  Kwaku Baryeh (kbaryeh@andrew.cmu.edu)
+ */
+
+#include "vehicles.h"
+#include "log.h"
+#include <algorithm>
+
+void init_vehicle_table(VehicleTable &t, const Problem &p) {
+    int n = p.cars.size();
+    t.position.assign(n, 0);
+    t.dest.assign(n, 0);
+    t.cursor.assign(n, 0);
+    t.route.assign(n, std::vector<uint8_t>());
+    t.route_version.assign(n, 0);
+    t.waited.assign(n, 0);
+    t.held.assign(n, 0);
+    t.origin.resize(n);
+    t.path.assign(n, std::vector<uint8_t>());
+    t.done.assign(n, 0);
+    t.active.clear();
+    t.slot.resize(n);
+    t.loaded.clear();
+    t.load.assign(p.graph.num_edges, 0);
+    t.depart.resize(n);
+    t.departures.clear();
+    t.next_departure = 0;
+
+    for (int i = 0; i < n; i++) {
+        t.position[i] = p.cars[i].src;
+        t.dest[i] = p.cars[i].dest;
+        t.origin[i] = p.cars[i].src;
+        t.depart[i] = p.cars[i].depart;
+        if (t.depart[i] > 0) {
+            t.slot[i] = -1;
+            t.departures.push_back(i);
+        } else {
+            t.slot[i] = t.active.size();
+            t.active.push_back(i);
+        }
+    }
+    std::stable_sort(t.departures.begin(), t.departures.end(),
+                     [&t](int a, int b) { return t.depart[a] < t.depart[b]; });
+    t.remaining = n;
+}
+
+void set_route(const Graph &graph, VehicleTable &t, int i, const std::vector<int> &route) {
+    std::vector<uint8_t> &hops = t.route[i];
+    hops.clear();
+    for (size_t k = 1; k < route.size(); k++) {
+        int local = find_edge(graph, route[k - 1], route[k]);
+        if (local < 0)
+            break;
+        put_hop(hops, local);
+    }
+    t.cursor[i] = 0;
+    t.route_version[i]++;
+}
+
+void clear_route(VehicleTable &t, int i) {
+    t.route[i].clear();
+    t.cursor[i] = 0;
+    t.route_version[i]++;
+}
+
+void advance_vehicle(const Graph &graph, VehicleTable &t, VehicleShard &shard, int i, EdgeRef edge) {
+    size_t pos = t.cursor[i];
+    get_hop(t.route[i].data(), pos);
+    t.cursor[i] = pos;
+    t.position[i] = hop_target(graph, edge.vertex, edge.local);
+    if (!t.held[i])
+        t.waited[i] = 0;
+    t.held[i] = 0;
+    put_hop(t.path[i], edge.local);
+    shard.moved.push_back(edge);
+}
+
+int find_edge(const Graph &graph, int u, int v) {
+    const EdgeList &list = graph.edges[u];
+    for (int localIdx = 0; localIdx < (int) list.size(); localIdx++) {
+        const Edge &edge = list[localIdx];
+        if ((edge.start == u && edge.end == v) || (edge.start == v && edge.end == u))
+            return localIdx;
+    }
+    return -1;
+}
+
+void deactivate_vehicle(VehicleTable &t, int i) {
+    int k = t.slot[i];
+    int last = t.active.back();
+    t.active[k] = last;
+    t.slot[last] = k;
+    t.active.pop_back();
+    t.slot[i] = -1;
+    t.remaining--;
+}
+
+void activate_vehicle(VehicleTable &t, int i) {
+    t.slot[i] = t.active.size();
+    t.active.push_back(i);
+    t.remaining++;
+}
+
+void retire_vehicles(VehicleTable &t, std::vector<VehicleShard> &shards) {
+    for (VehicleShard &shard : shards) {
+        for (int i : shard.finished) {
+            deactivate_vehicle(t, i);
+            t.done[i] = 1;
+        }
+        shard.finished.clear();
+    }
+}
+
+void release_departures(VehicleTable &t, int tick) {
+    while (t.next_departure < t.departures.size() && t.depart[t.departures[t.next_departure]] <= tick) {
+        int i = t.departures[t.next_departure++];
+        t.slot[i] = t.active.size();
+        t.active.push_back(i);
+        TRACE_EVENT(tick, i, TRACE_DEPART, t.position[i], 0);
+    }
+}
+
+int skip_idle_ticks(const VehicleTable &t, int tick) {
+    if (!t.active.empty() || !t.loaded.empty() || t.next_departure == t.departures.size())
+        return tick;
+    return std::max(tick, t.depart[t.departures[t.next_departure]]);
+}
+
+void seek_departures(VehicleTable &t, int tick) {
+    t.next_departure = 0;
+    while (t.next_departure < t.departures.size() && t.depart[t.departures[t.next_departure]] < tick)
+        t.next_departure++;
+}
+
+void update_edge_loads_current(const Graph &graph, VehicleTable &t, std::vector<VehicleShard> &shards) {
+    // Only the edges loaded last tick can be non-zero.
+    for (const EdgeRef &e : t.loaded)
+        t.load[graph.edges[e.vertex][e.local].id] = 0;
+    t.loaded.clear();
+
+    for (VehicleShard &shard : shards) {
+        for (const EdgeRef &e : shard.moved) {
+            if (t.load[graph.edges[e.vertex][e.local].id]++ == 0)
+                t.loaded.push_back(e);
+        }
+        shard.moved.clear();
+    }
+}
@@ -0,0 +1,295 @@
+/**
+ *          15-418 Final Project
+ *          Title:  Congestion Aware Map Routing
+ *          Credit: Parth Iyer   (pniyer@andrew.cmu.edu)
+ *                  Kwaku Baryeh (kbaryeh@andrew.cmu.edu)
+ */
+
+#ifndef VEHICLES_H
+#define VEHICLES_H
+
+#include "graph.h"
+#include "encoding.h"
+#include <vector>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#define CACHE_LINE_SIZE 64
+
+/**
+ * @name                AlignedAllocator
+ * @details             Allocator which hands out cache line aligned blocks so
+ *                      that every column of the vehicle table starts on its own
+ *                      cache line.
+ */
+template <typename T>
+struct AlignedAllocator {
+    typedef T value_type;
+
+    AlignedAllocator() {}
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U> &) {}
+
+    T *allocate(std::size_t n) {
+        void *ptr = NULL;
+        if (posix_memalign(&ptr, CACHE_LINE_SIZE, n * sizeof(T)) != 0)
+            throw std::bad_alloc();
+        return static_cast<T *>(ptr);
+    }
+
+    void deallocate(T *ptr, std::size_t) {
+        free(ptr);
+    }
+
+    template <typename U>
+    struct rebind { typedef AlignedAllocator<U> other; };
+};
+
+template <typename T, typename U>
+bool operator==(const AlignedAllocator<T> &, const AlignedAllocator<U> &) { return true; }
+template <typename T, typename U>
+bool operator!=(const AlignedAllocator<T> &, const AlignedAllocator<U> &) { return false; }
+
+template <typename T>
+using column = std::vector<T, AlignedAllocator<T>>;
+
+/**
+ * @name                EdgeRef
+ * @details             Names an edge by the vertex whose edge list holds it and
+ *                      its index within that list.
+ *
+ * @param vertex        The vertex owning the edge list
+ * @param local         The index of the edge in graph.edges[vertex]
+ */
+struct EdgeRef {
+    int vertex;
+    int local;
+};
+
+/**
+ * @name                hop_target
+ * @return              The vertex at the other end of edge `local` of u
+ */
+inline int hop_target(const Graph &graph, int u, int local) {
+    const Edge &edge = graph.edges[u][local];
+    return edge.start == u ? edge.end : edge.start;
+}
+
+/**
+ * @name                decode_hops
+ * @details             Appends the vertices the hops (see put_hop) from offset
+ *                      `from` on lead to, starting from vertex u.
+ */
+inline void decode_hops(const Graph &graph, int u, const std::vector<uint8_t> &hops, size_t from,
+                        std::vector<int> &out) {
+    size_t pos = from;
+    while (pos < hops.size()) {
+        u = hop_target(graph, u, get_hop(hops.data(), pos));
+        out.push_back(u);
+    }
+}
+
+/**
+ * @name                VehicleShard
+ * @details             Per-thread scratch space filled during a tick. Padded so
+ *                      that two shards never share a cache line.
+ *
+ * @param moved         Edges traversed by this shard's vehicles this tick
+ * @param finished      Vehicles which finished (or got stuck) this tick
+ * @param speculate     Vehicles whose next edge looks full for the next tick
+ * @param refine        Vehicles which got a weighted A* route this tick
+ * @param blocked       Vehicles which waited this tick, while gridlocks are
+ *                      looked for (see use_gridlock_policy)
+ * @param movers        The vehicle of each of `moved`, while gridlocks are
+ *                      looked for
+ */
+struct VehicleShard {
+    std::vector<EdgeRef> moved;
+    std::vector<int> finished;
+    std::vector<int> speculate;
+    std::vector<int> refine;
+    std::vector<int> blocked;
+    std::vector<int> movers;
+    char pad[CACHE_LINE_SIZE];
+};
+
+/**
+ * @name                VehicleTable
+ * @details             Structure-of-arrays state for every vehicle. Vehicles
+ *                      still en route are kept in the compacted `active` list;
+ *                      finished vehicles are swapped out of it so a tick only
+ *                      touches the vehicles which still have work to do.
+ *                      Vehicles which have not departed yet wait in the sorted
+ *                      `departures` list and are not touched at all.
+ *
+ *                      Routes and paths are stored as hops (see put_hop), one
+ *                      byte per edge on graphs of degree below 255 instead of
+ *                      a 4 byte vertex id, and the hop gives the edge itself,
+ *                      so the next edge is found without a search.
+ *
+ * @param position      The vertex each vehicle is currently at
+ * @param dest          The destination vertex of each vehicle
+ * @param cursor        Offset of the next hop within the vehicle's route
+ * @param route         The planned route of each vehicle, as hops from the
+ *                      vertex it was planned at
+ * @param route_version Counts the changes of each vehicle's route
+ * @param waited        Ticks each vehicle has waited since it last moved on
+ *                      two ticks in a row, so a vehicle which crawls along,
+ *                      waiting every other tick, keeps counting
+ * @param held          1 if each vehicle waited on the last tick it was stepped
+ * @param origin        The vertex each vehicle's path starts at
+ * @param path          The complete movement history of each vehicle, as
+ *                      hops from its origin
+ * @param done          1 once a vehicle reached its destination or got stuck
+ * @param active        Ids of the vehicles which are not done
+ * @param slot          The index of each vehicle in `active` (-1 if done)
+ * @param remaining     The number of vehicles which are not done, including
+ *                      those which have not departed
+ * @param loaded        Edges which carry load from the previous tick
+ * @param load          The number of vehicles which entered each edge in the
+ *                      previous tick, indexed by Edge::id
+ * @param depart        The tick at which each vehicle enters the network
+ * @param departures    Vehicles which depart after tick 0, by departure tick
+ * @param next_departure  Index of the first vehicle of `departures` not yet
+ *                      released into `active`
+ */
+struct VehicleTable {
+    column<int> position;
+    column<int> dest;
+    column<int> cursor;
+    std::vector<std::vector<uint8_t>> route;
+    column<int> route_version;
+    column<int> waited;
+    column<char> held;
+    column<int> origin;
+    std::vector<std::vector<uint8_t>> path;
+    column<char> done;
+    column<int> active;
+    column<int> slot;
+    int remaining;
+    std::vector<EdgeRef> loaded;
+    column<int> load;
+    column<int> depart;
+    std::vector<int> departures;
+    size_t next_departure;
+};
+
+/**
+ * @name                init_vehicle_table
+ * @details             Places every car of the problem at its source vertex
+ *                      on empty roads. Cars departing at tick 0 are marked
+ *                      active, the others are queued by departure tick.
+ *
+ * @param[out] t        The vehicle table to fill
+ * @param[in] p         The problem whose cars we are simulating
+ */
+void init_vehicle_table(VehicleTable &t, const Problem &p);
+
+/**
+ * @name                has_next_hop
+ * @details             Whether any of a vehicle's route is left.
+ */
+inline bool has_next_hop(const VehicleTable &t, int i) {
+    return t.cursor[i] < (int) t.route[i].size();
+}
+
+/**
+ * @name                next_edge
+ * @details             The local index, in graph.edges[position], of the next
+ *                      edge on a vehicle's route. Only valid when
+ *                      has_next_hop(t, i).
+ */
+inline int next_edge(const VehicleTable &t, int i) {
+    size_t pos = t.cursor[i];
+    return get_hop(t.route[i].data(), pos);
+}
+
+/**
+ * @name                set_route
+ * @details             Replaces the planned route of a vehicle. The route must
+ *                      start at the vehicle's current position. It is cut
+ *                      short before the first pair of vertices without an edge
+ *                      between them, so the vehicle replans there.
+ */
+void set_route(const Graph &graph, VehicleTable &t, int i, const std::vector<int> &route);
+
+/**
+ * @name                clear_route
+ * @details             Drops the planned route of a vehicle, so it replans.
+ */
+void clear_route(VehicleTable &t, int i);
+
+/**
+ * @name                advance_vehicle
+ * @details             Moves a vehicle one hop along its route and records the
+ *                      move in its path and in the shard's moved edges.
+ *
+ * @param[in] edge      The edge being traversed, the next one of the route
+ */
+void advance_vehicle(const Graph &graph, VehicleTable &t, VehicleShard &shard, int i, EdgeRef edge);
+
+/**
+ * @name                find_edge
+ * @details             Looks up the edge between u and v in graph.edges[u].
+ *
+ * @return              The local index of the edge or -1 if there is none
+ */
+int find_edge(const Graph &graph, int u, int v);
+
+/**
+ * @name                deactivate_vehicle
+ * @details             Swaps a vehicle out of the active list in O(1) without
+ *                      marking it done, e.g. when it migrates to another rank.
+ */
+void deactivate_vehicle(VehicleTable &t, int i);
+
+/**
+ * @name                activate_vehicle
+ * @details             Appends a vehicle to the active list.
+ */
+void activate_vehicle(VehicleTable &t, int i);
+
+/**
+ * @name                retire_vehicles
+ * @details             Marks every vehicle in the shards' finished lists done
+ *                      and swaps it out of the active list in O(1) per vehicle.
+ */
+void retire_vehicles(VehicleTable &t, std::vector<VehicleShard> &shards);
+
+/**
+ * @name                release_departures
+ * @details             Appends every queued vehicle departing at or before
+ *                      `tick` to the active list. Costs nothing while the next
+ *                      departure lies in the future.
+ */
+void release_departures(VehicleTable &t, int tick);
+
+/**
+ * @name                skip_idle_ticks
+ * @details             When no vehicle is on the road and no load is left over
+ *                      from the previous tick, the ticks until the next
+ *                      departure cannot change anything.
+ *
+ * @return              The next departure tick in that case, otherwise `tick`
+ */
+int skip_idle_ticks(const VehicleTable &t, int tick);
+
+/**
+ * @name                seek_departures
+ * @details             Repositions the departure queue for a simulation
+ *                      resuming at `tick`: vehicles departing before it have
+ *                      already been released.
+ */
+void seek_departures(VehicleTable &t, int tick);
+
+/**
+ * @name                update_edge_loads_current
+ * @details             Clears the loads of the edges used in the previous tick
+ *                      and loads the edges traversed in this tick, so the cost
+ *                      is proportional to the number of moves rather than to
+ *                      the size of the graph or the fleet.
+ */
+void update_edge_loads_current(const Graph &graph, VehicleTable &t, std::vector<VehicleShard> &shards);
+
+#endif // VEHICLES_H